@@ -157,4 +157,7 @@ void Application::CheckingControllerState(float deltaTime)
 		controllerPtr->CameraInputs(deltaTime);
 	}
 	controllerPtr->GeneralInputs(deltaTime);
+
+	// The scene culls the terrain against the same matrices the shader uses
+	scenePtr->SetCameraView(controllerPtr->mProjection * controllerPtr->cameraPtr->mView, controllerPtr->cameraPtr->GetCameraPosition());
 }
\ No newline at end of file
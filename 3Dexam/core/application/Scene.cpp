@@ -1,9 +1,14 @@
 #define GLM_ENABLE_EXPERIMENTAL
 
+#include <cmath>
 #include <memory>
 #include <glm/glm.hpp>
 #include "Scene.h"
 #include "graphical/Material.h"
+#include "utility/TerrainHeightfield.h"
+#include "utility/TriangleAdjacency.h"
+#include "utility/TriangleBinIndex.h"
+#include "utility/TriangleBVH.h"
 
 Scene::Scene()
 {
@@ -25,6 +30,8 @@ void Scene::RenderScene()
 		deltaTime = maxDeltaTime;
 	}
 
+	UpdateTerrainLoading();
+
 	// Spline update timer
 	splineTimer += deltaTime;
 	if (splineTimer > 1)
@@ -33,6 +40,7 @@ void Scene::RenderScene()
 		timerEnabled = true;
 	}
 
+	// Simulation pass, everything that moves is moved here once per frame, the render pass below only reads the results
 	Update(deltaTime);
 
 	glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
@@ -48,10 +56,18 @@ void Scene::RenderScene()
 		}
 		mShader->setBool("useTexture", actors.second->mUseTexture);
 
-		ActorSceneLogic(deltaTime, actors);
+		ActorSceneLogic(actors);
 
 		shouldRenderWireframe ? mSceneMeshes[actors.second->mName]->setWireframe = true : mSceneMeshes[actors.second->mName]->setWireframe = false;
 
+		// Culling and LOD selection for the terrain, in the actor's model space, meshes without a terrain ignore this
+		if (hasViewProjection)
+		{
+			glm::mat4 actorTransform = actors.second->GetActorTransform();
+			glm::vec3 modelCameraPosition = glm::vec3(glm::inverse(actorTransform) * glm::vec4(mCameraPosition, 1.f));
+			mSceneMeshes[actors.second->mName]->UpdateTerrainView(mViewProjection * actorTransform, modelCameraPosition);
+		}
+
 		mSceneMeshes[actors.second->mName]->RenderMesh();
 	}
 
@@ -67,7 +83,7 @@ void Scene::RenderScene()
 		}
 		mShader->setBool("useTexture", actors.second->mUseTexture);
 
-		ActorSceneLogic(deltaTime, actors);
+		ActorSceneLogic(actors);
 
 		shouldRenderWireframe ? mSceneMeshes[actors.second->mName]->setWireframe = true : mSceneMeshes[actors.second->mName]->setWireframe = false;
 
@@ -86,34 +102,31 @@ void Scene::RenderScene()
 		}
 		mShader->setBool("useTexture", actors.second->mUseTexture);
 
-		ActorSceneLogic(deltaTime, actors);
+		ActorSceneLogic(actors);
 
 		shouldRenderWireframe ? mSceneMeshes[actors.second->mName]->setWireframe = true : mSceneMeshes[actors.second->mName]->setWireframe = false;
 
 		mSceneMeshes[actors.second->mName]->RenderMesh();
 	}
 
-	// Handling the scene collision
-	HandleSceneCollision(deltaTime);
-
 	timerEnabled = false;
 }
 
-void Scene::Update(float deltaTime)
+void Scene::SetCameraView(const glm::mat4& viewProjection, const glm::vec3& cameraPosition)
 {
-	for (auto& actors : mSceneActors)
-	{
-		ActorSceneLogic(deltaTime, actors);
-	}
+	mViewProjection = viewProjection;
+	mCameraPosition = cameraPosition;
+	hasViewProjection = true;
+}
 
-	for (auto& actors : mSceneBallActors)
-	{
-		ActorSceneLogic(deltaTime, actors);
-	}
+void Scene::Update(float deltaTime)
+{
+	SimulatePhysics(deltaTime);
 
+	// Rebuilding the B-spline curves from the recorded ball positions
 	for (auto& actors : mBSplineActors)
 	{
-		ActorSceneLogic(deltaTime, actors);
+		DrawBSplineCurve(actors.second);
 	}
 }
 
@@ -121,11 +134,33 @@ void Scene::Update(float deltaTime)
 // **running before the "while loop" of main()**
 void Scene::LoadScene()
 {
+	mShader = new Shader("core/shader/Shader.vs", "core/shader/Shader.fs");
 	LoadTextures();
 	LoadMeshes();
 	LoadActors();
 }
 
+// Swapping in the full resolution terrain once its background load is done, the GL upload has to run on this thread
+void Scene::UpdateTerrainLoading()
+{
+	auto terrain = mSceneActors.find("PunktSky");
+	if (terrain != mSceneActors.end() && terrain->second->mMeshInfo->FinishAsyncTerrainLoad())
+	{
+		minTerrainLimit = terrain->second->mMeshInfo->minTerrainLimit;
+		maxTerrainLimit = terrain->second->mMeshInfo->maxTerrainLimit;
+		CustomArea = terrain->second->mMeshInfo->customArea;
+
+		// Cached ground triangles point into the preview mesh, the next query finds them again through the bin index
+		for (auto* actorMap : { &mSceneActors, &mSceneBallActors })
+		{
+			for (auto& actors : *actorMap)
+			{
+				actors.second->mGroundTriangle = SIZE_MAX;
+			}
+		}
+	}
+}
+
 // Texture loading, adding them into an unordered map
 void Scene::LoadTextures()
 {
@@ -144,7 +179,9 @@ void Scene::LoadMeshes()
 	mSceneMeshes["CubeMesh"] = std::make_shared<Mesh>(MeshShape::CUBE, mShader);
 	mSceneMeshes["CubeMeshColor"] = std::make_shared<Mesh>(MeshShape::CUBECOLOR, mShader);
 	mSceneMeshes["SphereMesh"] = std::make_shared<Mesh>(MeshShape::SPHERE, mShader);
-	mSceneMeshes["PunktSkyMesh"] = std::make_shared<Mesh>(MeshShape::PUNKTSKY, mShader);
+	PointCloudSettings terrainSettings;
+	terrainSettings.asyncLoading = true;
+	mSceneMeshes["PunktSkyMesh"] = std::make_shared<Mesh>(MeshShape::PUNKTSKY, mShader, terrainSettings);
 	mSceneMeshes["BSplineMesh"] = std::make_shared<Mesh>(MeshShape::BSPLINE, mShader);
 }
 
@@ -158,7 +195,8 @@ void Scene::LoadActors()
 	CustomArea = mSceneActors["PunktSky"]->mMeshInfo->customArea;
 }
 
-void Scene::ActorSceneLogic(float deltaTime, std::unordered_map<std::string, std::shared_ptr<Actor>>::value_type& actors)
+// Render pass side of an actor, setting the model matrix from the transform the simulation pass left behind
+void Scene::ActorSceneLogic(std::unordered_map<std::string, std::shared_ptr<Actor>>::value_type& actors)
 {
 	auto& actor = actors.second;
 	glm::mat4 transform;
@@ -167,35 +205,108 @@ void Scene::ActorSceneLogic(float deltaTime, std::unordered_map<std::string, std
 	{
 	case Actor::STATIC:
 		transform = actor->GetActorTransform();
-		mShader->setMat4("model", transform);
 		break;
 
 	case Actor::DYNAMICOBJECT:
-		glm::vec3 objectHeight;
-		glm::vec3 objectNormal;
-		if (shouldSimualtePhysics)
-		{
-			if (BarycentricCalculations(mSceneActors["PunktSky"], actor->GetActorPosition(), objectHeight, objectNormal))
-			{
-				actor->SetActorPosition(objectHeight);
-				ObjectPhysics(actor, deltaTime, objectNormal);
-				//std::cout << actor->GetActorPosition().x << ", " << actor->GetActorPosition().y << ", " << actor->GetActorPosition().z << "\n";
-			}
-		}
-		transform = actor->GetActorTransform();
-		mShader->setMat4("model", transform);
+		// Moved by PhysicsStep(), drawn between its last two states
+		transform = actor->GetInterpolatedTransform(physicsInterpolation);
 		break;
 
 	case Actor::SPLINE:
-		// Drawing the B-spline curve
-		DrawBSplineCurve(actor);
 		transform = actor->GetActorTransform();
-		mShader->setMat4("model", transform);
 		break;
 
 	default:
-		break;
+		return;
 	}
+
+	// No shader before LoadScene(), a headless scene still runs the same per actor logic
+	if (mShader) mShader->setMat4("model", transform);
+}
+
+// Running as many fixed physics steps as the frame time covers, so the simulation does not depend on the frame rate
+void Scene::SimulatePhysics(float deltaTime)
+{
+	physicsAccumulator += deltaTime;
+	int substeps = 0;
+	while (physicsAccumulator >= physicsTimeStep && substeps < maxPhysicsSubsteps)
+	{
+		PhysicsStep(physicsTimeStep);
+		physicsAccumulator -= physicsTimeStep;
+		substeps++;
+	}
+
+	// Past the cap the leftover time is dropped, the simulation falls behind real time instead of taking longer every frame
+	if (physicsAccumulator >= physicsTimeStep)
+	{
+		physicsAccumulator = std::fmod(physicsAccumulator, physicsTimeStep);
+	}
+	physicsInterpolation = physicsAccumulator / physicsTimeStep;
+}
+
+void Scene::PhysicsStep(float timeStep)
+{
+	physicsStepCount++;
+
+	// Gathering the dynamic actors once, their ground contact is resolved for all of them together below
+	physicsActors.clear();
+	for (auto* actorMap : { &mSceneActors, &mSceneBallActors })
+	{
+		for (auto& actors : *actorMap)
+		{
+			auto& actor = actors.second;
+			if (actor->mActorType != Actor::DYNAMICOBJECT) continue;
+
+			actor->SavePhysicsState();
+			if (shouldSimualtePhysics) physicsActors.emplace_back(actor);
+		}
+	}
+
+	std::shared_ptr<Actor>& terrain = mSceneActors["PunktSky"];
+	if (!physicsActors.empty())
+	{
+		if (std::shared_ptr<const TerrainHeightfield> heightfield = terrain->mMeshInfo->GetHeightfield())
+		{
+			// Gridded terrain, one batched query for every actor's x and z instead of one Sample() call per actor
+			size_t actorCount = physicsActors.size();
+			groundX.resize(actorCount);
+			groundZ.resize(actorCount);
+			groundHeights.resize(actorCount);
+			groundNormals.resize(actorCount);
+			groundHits.resize(actorCount);
+			for (size_t actor = 0; actor < actorCount; ++actor)
+			{
+				glm::vec3 position = physicsActors[actor]->GetActorPosition();
+				groundX[actor] = position.x;
+				groundZ[actor] = position.z;
+			}
+			heightfield->SampleBatch(groundX, groundZ, groundHeights, groundNormals, groundHits);
+
+			for (size_t actor = 0; actor < actorCount; ++actor)
+			{
+				if (!groundHits[actor]) continue;
+				physicsActors[actor]->SetActorPosition(glm::vec3(groundX[actor], groundHeights[actor] + 1.f, groundZ[actor]));
+				ObjectPhysics(physicsActors[actor], timeStep, groundNormals[actor]);
+			}
+		}
+		else
+		{
+			// Simplified or non grid terrain, each actor walks from the triangle it stood on last step
+			for (auto& actor : physicsActors)
+			{
+				glm::vec3 objectHeight;
+				glm::vec3 objectNormal;
+				if (BarycentricCalculations(terrain, actor->GetActorPosition(), objectHeight, objectNormal, actor->mGroundTriangle))
+				{
+					actor->SetActorPosition(objectHeight);
+					ObjectPhysics(actor, timeStep, objectNormal);
+				}
+			}
+		}
+	}
+
+	// Handling the scene collision
+	HandleSceneCollision(timeStep);
 }
 
 void Scene::HandleSceneCollision(float deltaTime)
@@ -292,50 +403,44 @@ void Scene::ResolveCollision(const CollisionInfo& collision)
 	ballB->SetActorPosition(newPosB);
 }
 
-bool Scene::BarycentricCalculations(std::shared_ptr<Actor>& objectToCheck, glm::vec3 targetedPos, glm::vec3& newPositionVector, glm::vec3& normal)
+bool Scene::BarycentricCalculations(std::shared_ptr<Actor>& objectToCheck, glm::vec3 targetedPos, glm::vec3& newPositionVector, glm::vec3& normal, size_t& cachedTriangle)
 {
-	glm::vec3 targetPosition = glm::vec3(targetedPos.x, targetedPos.z, 0);
+	Mesh& mesh = *objectToCheck->mMeshInfo;
 
-	for (size_t i = 0; i < objectToCheck->mMeshInfo->mIndices.size(); i += 3)
+	// Gridded terrain, the cell and triangle come straight from x and z
+	if (std::shared_ptr<const TerrainHeightfield> heightfield = mesh.GetHeightfield())
 	{
-		int P1 = objectToCheck->mMeshInfo->mIndices[i];
-		int P2 = objectToCheck->mMeshInfo->mIndices[i + 1];
-		int P3 = objectToCheck->mMeshInfo->mIndices[i + 2];
+		HeightfieldSample sample;
+		if (!heightfield->Sample(targetedPos.x, targetedPos.z, sample)) return false;
 
-		glm::vec3 P = glm::vec3(objectToCheck->mMeshInfo->mVertices[P1].mPosition.x, objectToCheck->mMeshInfo->mVertices[P1].mPosition.z, 0.f);
-		glm::vec3 Q = glm::vec3(objectToCheck->mMeshInfo->mVertices[P2].mPosition.x, objectToCheck->mMeshInfo->mVertices[P2].mPosition.z, 0.f);
-		glm::vec3 R = glm::vec3(objectToCheck->mMeshInfo->mVertices[P3].mPosition.x, objectToCheck->mMeshInfo->mVertices[P3].mPosition.z, 0.f);
-
-		glm::vec3 PQ = Q - P;
-		glm::vec3 PR = R - P;
-		float area = glm::length(glm::cross(PQ, PR));
-
-		float U = glm::cross(Q - targetPosition, R - targetPosition).z / area;
-		float V = glm::cross(R - targetPosition, P - targetPosition).z / area;
-		float W = glm::cross(P - targetPosition, Q - targetPosition).z / area;
+		// Set the new position with the correct Y value
+		newPositionVector = glm::vec3(targetedPos.x, sample.height + 1.f, targetedPos.z);
+		normal = sample.normal;
+		return true;
+	}
 
-		// Use a small tolerance to handle floating-point precision issues
-		const float tolerance = 1e-5f;
-		if (U >= -tolerance && V >= -tolerance && W >= -tolerance && std::abs(U + V + W - 1.0f) <= tolerance)
-		{
-			// Calculate the new Y position using barycentric coordinates
-			float newY = U * objectToCheck->mMeshInfo->mVertices[P1].mPosition.y +
-				V * objectToCheck->mMeshInfo->mVertices[P2].mPosition.y +
-				W * objectToCheck->mMeshInfo->mVertices[P3].mPosition.y;
+	// Any other mesh, walking from the triangle the actor stood on last time, which is usually the same one or a neighbour
+	// The binned lookup is the fallback for the first query, a start outside the mesh or a walk that gives up
+	size_t triangle;
+	glm::vec3 barycentric;
+	if (!mesh.GetTriangleAdjacency().Walk(mesh.mVertices, mesh.mIndices, cachedTriangle, targetedPos.x, targetedPos.z, triangle, barycentric) &&
+		!mesh.GetTriangleIndex().FindTriangle(mesh.mVertices, mesh.mIndices, targetedPos.x, targetedPos.z, triangle, barycentric))
+	{
+		return false;
+	}
+	cachedTriangle = triangle;
 
-			// Set the new position with the correct Y value
-			newPositionVector = glm::vec3(targetedPos.x, newY + 1.f, targetedPos.z);
+	const Vertex& P = mesh.mVertices[mesh.mIndices[triangle * 3]];
+	const Vertex& Q = mesh.mVertices[mesh.mIndices[triangle * 3 + 1]];
+	const Vertex& R = mesh.mVertices[mesh.mIndices[triangle * 3 + 2]];
 
-			// Calculate the normal of the triangle
-			glm::vec3 normalP = objectToCheck->mMeshInfo->mVertices[P1].mNormal;
-			glm::vec3 normalQ = objectToCheck->mMeshInfo->mVertices[P2].mNormal;
-			glm::vec3 normalR = objectToCheck->mMeshInfo->mVertices[P3].mNormal;
-			normal = glm::normalize(U * normalP + V * normalQ + W * normalR);
+	// Calculate the new Y position using barycentric coordinates
+	float newY = barycentric.x * P.mPosition.y + barycentric.y * Q.mPosition.y + barycentric.z * R.mPosition.y;
+	newPositionVector = glm::vec3(targetedPos.x, newY + 1.f, targetedPos.z);
 
-			return true;
-		}
-	}
-	return false;
+	// Interpolating the normal of the triangle
+	normal = glm::normalize(barycentric.x * P.mNormal + barycentric.y * Q.mNormal + barycentric.z * R.mNormal);
+	return true;
 }
 
 void Scene::FrictionUpdate(std::shared_ptr<Actor>& objectToUpdate, float deltaTime, const glm::vec3& normal)
@@ -379,29 +484,68 @@ glm::vec3 Scene::CalculateReflection(const glm::vec3& velocity, const glm::vec3&
 	return reflection;
 }
 
-void Scene::SpawnObjects()
+void Scene::SpawnObjects(glm::vec2 cursorPosition)
 {
-	float spawnPositionX = 0;
-	float spawnPositionZ = 0;
-	std::cout << "Enter a position between (" << minTerrainLimit.x << ", " << minTerrainLimit.z << ") and (" << maxTerrainLimit.x << ", " << maxTerrainLimit.z << ") \n";
-	std::cout << "X position: "; std::cin >> spawnPositionX;
-	std::cout << "Z position: "; std::cin >> spawnPositionZ;
-	if (spawnPositionX < minTerrainLimit.x || spawnPositionX > maxTerrainLimit.x
-		|| spawnPositionZ < minTerrainLimit.z || spawnPositionZ > maxTerrainLimit.z)
+	if (!hasViewProjection) return;
+
+	// The cursor ray runs from the near to the far plane, cursorPosition is in normalized device coordinates
+	glm::mat4 inverseViewProjection = glm::inverse(mViewProjection);
+	glm::vec4 nearPoint = inverseViewProjection * glm::vec4(cursorPosition, -1.f, 1.f);
+	glm::vec4 farPoint = inverseViewProjection * glm::vec4(cursorPosition, 1.f, 1.f);
+	glm::vec3 rayOrigin = glm::vec3(nearPoint) / nearPoint.w;
+	glm::vec3 rayDirection = glm::vec3(farPoint) / farPoint.w - rayOrigin;
+
+	HeightfieldRayHit hit;
+	if (!RaycastTerrain(rayOrigin, rayDirection, 1.f, hit))
+	{
+		std::cout << "No terrain under the cursor, nothing spawned \n";
+		return;
+	}
+	std::cout << "Spawned object at position (" << hit.point.x << ", " << hit.point.z << ") \n";
+	SpawnSetup(hit.point + glm::vec3(0.f, spawnHeightAboveGround, 0.f));
+}
+
+bool Scene::RaycastTerrain(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, HeightfieldRayHit& hit)
+{
+	auto terrain = mSceneActors.find("PunktSky");
+	if (terrain == mSceneActors.end()) return false;
+	Mesh& mesh = *terrain->second->mMeshInfo;
+
+	// Queried in the terrain's model space, distances stay the same since the direction is transformed along with the origin
+	glm::mat4 actorTransform = terrain->second->GetActorTransform();
+	glm::mat4 inverseTransform = glm::inverse(actorTransform);
+	glm::vec3 modelOrigin = glm::vec3(inverseTransform * glm::vec4(origin, 1.f));
+	glm::vec3 modelDirection = glm::vec3(inverseTransform * glm::vec4(direction, 0.f));
+
+	// Gridded terrain walks the heightfield cells, any other mesh goes through its triangle BVH
+	if (std::shared_ptr<const TerrainHeightfield> heightfield = mesh.GetHeightfield())
 	{
-		std::cout << "Error, coordinates is out of bounds! \n";
+		if (!heightfield->Raycast(modelOrigin, modelDirection, maxDistance, hit)) return false;
 	}
 	else
 	{
-		std::cout << "Spawned object at position (" << spawnPositionX << ", " << spawnPositionZ << ") \n";
-		SpawnSetup(spawnPositionX, spawnPositionZ);
+		TriangleHit triangleHit;
+		if (!mesh.GetTriangleBVH().Raycast(modelOrigin, modelDirection, maxDistance, triangleHit)) return false;
+
+		const Vertex& P = mesh.mVertices[mesh.mIndices[triangleHit.triangle * 3]];
+		const Vertex& Q = mesh.mVertices[mesh.mIndices[triangleHit.triangle * 3 + 1]];
+		const Vertex& R = mesh.mVertices[mesh.mIndices[triangleHit.triangle * 3 + 2]];
+		hit.point = triangleHit.point;
+		hit.barycentric = triangleHit.barycentric;
+		hit.triangle = triangleHit.triangle;
+		hit.distance = triangleHit.distance;
+		hit.normal = glm::normalize(hit.barycentric.x * P.mNormal + hit.barycentric.y * Q.mNormal + hit.barycentric.z * R.mNormal);
 	}
+
+	hit.point = glm::vec3(actorTransform * glm::vec4(hit.point, 1.f));
+	hit.normal = glm::normalize(glm::transpose(glm::mat3(inverseTransform)) * hit.normal);
+	return true;
 }
 
-void Scene::SpawnSetup(float spawnPositionX, float spawnPositionZ)
+void Scene::SpawnSetup(glm::vec3 spawnPosition)
 {
 	mSceneMeshes["BSplineMesh" + std::to_string(objectsSpawned)] = std::make_shared<Mesh>(MeshShape::BSPLINE, mShader);
-	mSceneBallActors["Object" + std::to_string(objectsSpawned)] = (std::make_shared<Actor>("SphereMesh", mSceneMeshes["SphereMesh"], glm::vec3{ spawnPositionX, 130.f, spawnPositionZ }, glm::vec3{ 1.f, 0.f, 0.f }, 0.f, 1.f, Actor::ActorType::DYNAMICOBJECT, mShader, false, ""));
+	mSceneBallActors["Object" + std::to_string(objectsSpawned)] = (std::make_shared<Actor>("SphereMesh", mSceneMeshes["SphereMesh"], spawnPosition, glm::vec3{ 1.f, 0.f, 0.f }, 0.f, 1.f, Actor::ActorType::DYNAMICOBJECT, mShader, false, ""));
 	mBSplineActors["Spline" + std::to_string(objectsSpawned)] = (std::make_shared<Actor>("BSplineMesh" + std::to_string(objectsSpawned), mSceneMeshes["BSplineMesh" + std::to_string(objectsSpawned)], glm::vec3{ 0.f, 0.f, 0.f }, glm::vec3{ 1.f, 0.f, 0.f }, 0.f, 1.f, Actor::ActorType::SPLINE, mShader, false, ""));
 	mBSplineActors["Spline" + std::to_string(objectsSpawned)]->ballPtr = mSceneBallActors["Object" + std::to_string(objectsSpawned)];
 	objectsSpawned++;
@@ -429,6 +573,8 @@ void Scene::DrawBSplineCurve(std::shared_ptr<Actor>& objectToUpdate)
 
 void Scene::ObjectPhysics(std::shared_ptr<Actor>& objectToUpdate, float deltaTime, glm::vec3& normal)
 {
+	objectToUpdate->mPhysicsIntegrations++;
+
 	// Calculate the acceleration and velocity for the actor based on the normal
 	VelocityUpdate(objectToUpdate, CalculateAccelerationVector(normal), deltaTime);
 
@@ -10,6 +10,7 @@
 #include "graphical/Mesh.h"
 #include "graphical/Texture.h"
 #include "utility/Octree.h"
+#include "utility/TerrainHeightfield.h"
 
 class memory;
 
@@ -31,6 +32,7 @@ public:
 	Scene();
 	void RenderScene();
 	void Update(float deltaTime);
+	void SetCameraView(const glm::mat4& viewProjection, const glm::vec3& cameraPosition);
 
 	/*
 	 * Loading
@@ -40,11 +42,14 @@ public:
 	void LoadMeshes();
 	//void LoadMaterials();
 	void LoadActors();
+	void UpdateTerrainLoading();
 
 	/*
 	 * Scene logic
 	 */
-	void ActorSceneLogic(float deltaTime, std::unordered_map<std::string, std::shared_ptr<Actor>>::value_type& actors);
+	void ActorSceneLogic(std::unordered_map<std::string, std::shared_ptr<Actor>>::value_type& actors);
+	void SimulatePhysics(float deltaTime);
+	void PhysicsStep(float timeStep);
 	/*Collision logic*/
 	void HandleSceneCollision(float deltaTime);
 	std::vector<CollisionInfo> DetectAllCollisions();
@@ -52,8 +57,9 @@ public:
 
 	/*Helper functions*/
 	glm::vec3 CalculateReflection(const glm::vec3& velocity, const glm::vec3& normal);
-	void SpawnObjects();
-	void SpawnSetup(float spawnPositionX, float spawnPositionZ);
+	void SpawnObjects(glm::vec2 cursorPosition);
+	void SpawnSetup(glm::vec3 spawnPosition);
+	bool RaycastTerrain(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, HeightfieldRayHit& hit);
 	void DeleteObjects();
 	void DrawBSplineCurve(std::shared_ptr<Actor>& objectToUpdate);
 
@@ -63,7 +69,7 @@ public:
 	void ObjectPhysics(std::shared_ptr<Actor>& objectToUpdate, float deltaTime, glm::vec3& normal);
 	glm::vec3 CalculateAccelerationVector(glm::vec3& normal);
 	void VelocityUpdate(std::shared_ptr<Actor>& objectToUpdate, const glm::vec3& acceleration, float deltaTime);
-	bool BarycentricCalculations(std::shared_ptr<Actor>& objectToCheck, glm::vec3 targetedPos, glm::vec3& newPositionVector, glm::vec3& normal);
+	bool BarycentricCalculations(std::shared_ptr<Actor>& objectToCheck, glm::vec3 targetedPos, glm::vec3& newPositionVector, glm::vec3& normal, size_t& cachedTriangle);
 	void FrictionUpdate(std::shared_ptr<Actor>& objectToUpdate, float deltaTime, const glm::vec3& normal);
 
 	/*
@@ -74,7 +80,7 @@ public:
 	std::unordered_map<std::string, std::shared_ptr<Actor>> mSceneActors;
 	std::unordered_map<std::string, std::shared_ptr<Actor>> mSceneBallActors;
 	std::unordered_map<std::string, std::shared_ptr<Actor>> mBSplineActors;
-	Shader* mShader = new Shader("core/shader/Shader.vs", "core/shader/Shader.fs");
+	Shader* mShader{ nullptr }; // Created by LoadScene(), which needs a current GL context
 	std::chrono::time_point<std::chrono::high_resolution_clock> previousTime;
 	float deltaTime;
 	bool hasSetNewLine{ false };
@@ -82,15 +88,30 @@ public:
 	float splineTimer{ 0 };
 	float splineTimer2{ 0 };
 	bool timerEnabled{ false };
+	glm::mat4 mViewProjection{ 1.f };
+	glm::vec3 mCameraPosition{ 0.f };
+	bool hasViewProjection{ false };
 
 	/*Terrain Variables*/
 	glm::vec3 minTerrainLimit{ 0.f, 0.f, 0.f, };
 	glm::vec3 maxTerrainLimit{ 0.f, 0.f, 0.f, };
 	int objectsSpawned{ 0 };
+	float spawnHeightAboveGround{ 10.f }; // Objects are dropped from this far above the picked terrain point
 	std::vector<CustomArea> CustomArea;
 
 	/*Physics Variables*/
 	bool shouldSimualtePhysics{ false };
+	float physicsTimeStep{ 1.f / 120.f }; // Seconds per simulation step, independent of the frame rate
+	int maxPhysicsSubsteps{ 8 }; // Steps per frame before the leftover time is dropped
+	float physicsAccumulator{ 0.f }; // Frame time not simulated yet, always less than one step after SimulatePhysics()
+	float physicsInterpolation{ 0.f }; // How far rendering is from the previous physics state to the current one, 0 to 1
+	uint64_t physicsStepCount{ 0 }; // Physics steps run since the scene started
+	std::vector<std::shared_ptr<Actor>> physicsActors; // Dynamic actors of the current step, the buffers below are kept between steps
+	std::vector<float> groundX; // Actor positions and the terrain under them, one entry per physics actor for the batched heightfield query
+	std::vector<float> groundZ;
+	std::vector<float> groundHeights;
+	std::vector<glm::vec3> groundNormals;
+	std::vector<uint8_t> groundHits;
 	std::unordered_map<std::shared_ptr<Actor>, std::vector<glm::vec3>> ballPositions;
 
 	/*Material variables*/
@@ -18,6 +18,7 @@ Actor::Actor(const std::string& meshName, std::shared_ptr<Mesh> meshInfo, glm::v
 
 {
 	mActorMass = 1.f;
+	mPreviousActorPosition = position;
 	ActorTransform();
 }
 
@@ -38,10 +39,19 @@ glm::mat4 Actor::SetActorTransform(glm::vec3 position, float scale)
 	model = glm::rotate(model, glm::radians(mActorRotation), mActorRotationAxis);
 	model = glm::scale(model, glm::vec3{ scale });
 	mActorTransform = model;
-	mShader->setMat4("model", mActorTransform);
 	return mActorTransform;
 }
 
+// The transform alpha of the way from the previous physics position to the current one
+glm::mat4 Actor::GetInterpolatedTransform(float alpha) const
+{
+	glm::mat4 model{ 1.f };
+	model = glm::translate(model, glm::mix(mPreviousActorPosition, mActorPosition, alpha));
+	model = glm::rotate(model, glm::radians(mActorRotation), mActorRotationAxis);
+	model = glm::scale(model, glm::vec3{ mActorScale });
+	return model;
+}
+
 void Actor::SetActorPosition(glm::vec3 position)
 {
 	mActorPosition = position;
@@ -45,6 +45,12 @@ public:
 	float GetActorRadius() const { return mActorRadius; }
 	float GetActorMass() const { return mActorMass; }
 
+	/*
+	 * Render interpolation between the last two physics states
+	 */
+	void SavePhysicsState() { mPreviousActorPosition = mActorPosition; }
+	glm::mat4 GetInterpolatedTransform(float alpha) const;
+
 	/*
 	 * Member Variables
 	 */
@@ -64,6 +70,8 @@ public:
 	float mActorSpeed{ 20.f };
 	bool shouldActorCollide{ false };
 	std::shared_ptr<Actor> ballPtr;
+	size_t mGroundTriangle{ SIZE_MAX }; // Ground triangle found on the last query, where the next one starts walking from
+	uint64_t mPhysicsIntegrations{ 0 }; // Times ObjectPhysics() has moved the actor, once per physics step while it is over the terrain
 	// Pointers
 	std::unique_ptr<RandomNumberGenerator> RandomNumberGenerator;
 
@@ -75,6 +83,7 @@ private:
 	float mActorRotation{ 30.f };
 	glm::mat4 mActorTransform{ 0.f };
 	glm::vec3 mActorVelocity{ 0.f, 0.f, 0.f };
+	glm::vec3 mPreviousActorPosition{ 0.f }; // Position before the last physics step
 	float mActorMass{ 1.f };
 	float mActorRadius{ 1.f };
 };
@@ -1,18 +1,117 @@
 #include "Mesh.h"
 
 #include <algorithm>
-#include <numeric>
+#include <atomic>
+#include <chrono>
+#include <limits>
 #include <unordered_map>
 #include <glad/glad.h>
 
+#include "graphical/TerrainRenderer.h"
+#include "utility/CellBinIndex.h"
+#include "utility/CompactPointCloud.h"
+#include "utility/Frustum.h"
+#include "utility/LasReader.h"
 #include "utility/MathLibrary.h"
+#include "utility/PointCloudCache.h"
+#include "utility/PointKernels.h"
 #include "utility/ReadWriteFiles.h"
+#include "utility/SampleAccumulator.h"
+#include "utility/TerrainHeightfield.h"
+#include "utility/ThreadPool.h"
+#include "utility/TriangleAdjacency.h"
+#include "utility/TriangleBinIndex.h"
+#include "utility/TriangleBVH.h"
+#include "utility/VoxelGridFilter.h"
 
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
 #endif
 
-Mesh::Mesh(MeshShape meshShape, Shader* meshShader) : mMeshShape(meshShape), mMeshShader(meshShader)
+namespace
+{
+	// Gives a vertex vector the same point access as CompactPointCloud, so the terrain gridding can take either
+	struct VertexPointSource
+	{
+		const std::vector<Vertex>& vertices;
+
+		size_t GetPointCount() const { return vertices.size(); }
+		const glm::vec3& GetPosition(size_t index) const { return vertices[index].mPosition; }
+		const glm::vec3& GetColor(size_t index) const { return vertices[index].mColor; }
+		const Vertex& GetVertex(size_t index) const { return vertices[index]; }
+	};
+
+	// Vertices with their recentered x and z held in separate arrays, the grid binning reads those arrays directly
+	struct RecenteredVertexPointSource
+	{
+		const std::vector<Vertex>& vertices;
+		const std::vector<float>& pointX;
+		const std::vector<float>& pointZ;
+
+		size_t GetPointCount() const { return vertices.size(); }
+		glm::vec3 GetPosition(size_t index) const { return glm::vec3(pointX[index], vertices[index].mPosition.y, pointZ[index]); }
+		const glm::vec3& GetColor(size_t index) const { return vertices[index].mColor; }
+		Vertex GetVertex(size_t index) const
+		{
+			Vertex vertex = vertices[index];
+			vertex.mPosition = GetPosition(index);
+			return vertex;
+		}
+		const float* GetPointsX() const { return pointX.data(); }
+		const float* GetPointsZ() const { return pointZ.data(); }
+	};
+
+	// Runs rowTask(row) for every grid row, rows are handed out one at a time so the workers stay balanced
+	// Every row only writes its own vertices, so the result is the same for any thread count
+	template <typename RowTask>
+	void RunOverGridRows(int rowCount, unsigned int threadCount, const char* stageName, RowTask rowTask)
+	{
+		threadCount = std::min<unsigned int>(ThreadPool::ResolveThreadCount(threadCount), std::max(rowCount, 1));
+		std::atomic<int> nextRow{ 0 };
+		std::atomic<int> rowsComplete{ 0 };
+		auto worker = [&]()
+			{
+				for (int row = nextRow++; row < rowCount; row = nextRow++)
+				{
+					rowTask(row);
+					rowsComplete++;
+				}
+			};
+
+		if (threadCount <= 1)
+		{
+			worker();
+		}
+		else
+		{
+			ThreadPool pool(threadCount);
+			std::vector<std::future<void>> workers;
+			for (unsigned int i = 0; i < threadCount; ++i)
+			{
+				workers.emplace_back(pool.Submit(worker));
+			}
+
+			// Progress is only printed from this thread, in steps of 10%
+			int reportedPercentage = 0;
+			for (auto& result : workers)
+			{
+				while (result.wait_for(std::chrono::milliseconds(100)) != std::future_status::ready)
+				{
+					int percentageComplete = rowsComplete * 100 / rowCount;
+					if (percentageComplete >= reportedPercentage + 10)
+					{
+						reportedPercentage = percentageComplete - percentageComplete % 10;
+						std::cout << stageName << " " << reportedPercentage << "% complete\n";
+					}
+				}
+				result.get();
+			}
+		}
+		std::cout << stageName << " complete on " << threadCount << " threads\n";
+	}
+}
+
+Mesh::Mesh(MeshShape meshShape, Shader* meshShader, const PointCloudSettings& pointCloudSettings) : mMeshShape(meshShape), mMeshShader(meshShader), mPointCloudSettings(pointCloudSettings)
 {
 	switch (mMeshShape)
 	{
@@ -45,7 +144,14 @@ Mesh::Mesh(MeshShape meshShape, Shader* meshShader) : mMeshShape(meshShape), mMe
 		break;
 
 	case MeshShape::PUNKTSKY:
-		CreateMeshFromPointCloud(150, false, { 1.f, 1.f, 1.f });
+		if (mPointCloudSettings.asyncLoading)
+		{
+			StartAsyncTerrainLoad(150, false, { 1.f, 1.f, 1.f });
+		}
+		else
+		{
+			CreateMeshFromPointCloud(150, false, { 1.f, 1.f, 1.f });
+		}
 		break;
 
 	case MeshShape::BSPLINE:
@@ -59,6 +165,14 @@ Mesh::Mesh(MeshShape meshShape, Shader* meshShader) : mMeshShape(meshShape), mMe
 	MeshSetup();
 }
 
+Mesh::Mesh(const PointCloudSettings& pointCloudSettings, int resolution, bool usingBSpling, glm::vec3 cloudScale) : mMeshShape(MeshShape::PUNKTSKY), mMeshShader(nullptr), mPointCloudSettings(pointCloudSettings)
+{
+	// No GL calls here, so this can run on a worker thread
+	CreateMeshFromPointCloud(resolution, usingBSpling, cloudScale);
+}
+
+Mesh::~Mesh() = default;
+
 void Mesh::RenderMesh()
 {
 	mMeshShader->setInt("texture1", 0);
@@ -96,12 +210,36 @@ void Mesh::RenderMesh()
 		{
 			glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
 		}
-		glDrawElements(GL_TRIANGLES, mIndices.size(), GL_UNSIGNED_INT, 0);
+		if (mTerrainRenderer)
+		{
+			// Heightmap terrain, the shared patch is drawn once per selected quadtree node
+			mTerrainRenderer->Render(*mMeshShader);
+		}
+		else if (mHasCulledTiles)
+		{
+			// Only the terrain tiles that passed CullTerrainTiles(), neighbouring visible tiles share one draw call
+			for (const auto& range : mVisibleIndexRanges)
+			{
+				glDrawElements(GL_TRIANGLES, range.second, GL_UNSIGNED_INT, reinterpret_cast<void*>(range.first * sizeof(Index)));
+			}
+		}
+		else
+		{
+			glDrawElements(GL_TRIANGLES, mIndices.size(), GL_UNSIGNED_INT, 0);
+		}
 	}
 }
 
 void Mesh::MeshSetup()
 {
+	if (mMeshShape == MeshShape::PUNKTSKY && mPointCloudSettings.heightmapRendering)
+	{
+		// Height texture and one shared patch instead of the full vertex and index buffers
+		mTerrainRenderer = std::make_unique<TerrainRenderer>();
+		if (mTerrainRenderer->Setup(mVertices, mGridResolution)) return;
+		mTerrainRenderer.reset();
+	}
+
 	// Setting up and binding the mesh
 	glGenVertexArrays(1, &mVAO);
 	glBindVertexArray(mVAO);
@@ -120,6 +258,23 @@ void Mesh::MeshSetup()
 	Vertex::SetupAttributes();
 }
 
+void Mesh::UploadMeshData()
+{
+	if (mTerrainRenderer)
+	{
+		mTerrainRenderer->Setup(mVertices, mGridResolution);
+		return;
+	}
+
+	// Refilling the buffers made by MeshSetup(), the vertex layout in the VAO stays the same
+	glBindVertexArray(mVAO);
+	glBindBuffer(GL_ARRAY_BUFFER, mVBO);
+	glBufferData(GL_ARRAY_BUFFER, mVertices.size() * sizeof(Vertex), mVertices.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mEBO);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, mIndices.size() * sizeof(Index), mIndices.data(), GL_STATIC_DRAW);
+	glBindVertexArray(0);
+}
+
 void Vertex::SetupAttributes()
 {
 	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, mPosition));
@@ -420,37 +575,104 @@ float Mesh::BSplineBasis(int i, int degree, float t, const std::vector<float>& k
 
 void Mesh::CreateMeshFromPointCloud(int resolution, bool usingBSpling, glm::vec3 cloudScale)
 {
+	if (mPointCloudSettings.streamingGrid)
+	{
+		// Binning the points straight from the file, the point cloud is never held in memory
+		StreamPointCloudIntoGrid(resolution, usingBSpling, cloudScale);
+		if (!mVertices.empty()) FinishTerrainGrid(resolution);
+		return;
+	}
+
+	if (mPointCloudSettings.compactPoints)
+	{
+		// Holding the point cloud as 16 byte quantised points instead of full vertices
+		if (mPointCloudSettings.useBinaryCache && !PointCloudCache::IsBinaryPointFile(mPointCloudSettings.filePath) && !LasReader::IsLasFile(mPointCloudSettings.filePath))
+		{
+			ReadWriteFiles::WritePointCloudCacheFromText(mPointCloudSettings.filePath, mPointCloudSettings.usingColors);
+		}
+
+		CompactPointCloud points;
+		if (!CompactPointCloud::LoadFromFile(mPointCloudSettings.filePath, mPointCloudSettings.usingColors, points)) return;
+		VoxelGridFilter::Downsample(points, mPointCloudSettings.voxelSize, mPointCloudSettings.threadCount);
+
+		glm::vec3 boundsMin = points.GetBoundsMin();
+		glm::vec3 boundsMax = points.GetBoundsMax();
+		std::cout << "Min and Max found for x and z\n";
+
+		// Recentering only moves the dequantisation offset, the points themselves are untouched
+		points.Translate(glm::vec3(-(boundsMin.x + boundsMax.x) / 2.f, 0.f, -(boundsMin.z + boundsMax.z) / 2.f));
+		std::cout << "Vertices recentered\n";
+
+		BuildTerrainFromPoints(resolution, usingBSpling, points, boundsMin.x, boundsMax.x, boundsMin.z, boundsMax.z, cloudScale);
+		FinishTerrainGrid(resolution);
+		return;
+	}
+
 	// Loading vertices from file into a temp vector
 	std::vector<Vertex> tempVertices;
-	ReadWriteFiles::FromDataToVertexVector("TerrainData.txt", tempVertices, true);
+	if (LasReader::IsLasFile(mPointCloudSettings.filePath))
+	{
+		ReadWriteFiles::FromLasDataToVertexVector(mPointCloudSettings.filePath, tempVertices, mPointCloudSettings.usingColors, mPointCloudSettings.threadCount);
+	}
+	else if (PointCloudCache::IsBinaryPointFile(mPointCloudSettings.filePath))
+	{
+		ReadWriteFiles::FromBinaryDataToVertexVector(mPointCloudSettings.filePath, tempVertices, mPointCloudSettings.usingColors);
+	}
+	else if (mPointCloudSettings.useBinaryCache)
+	{
+		ReadWriteFiles::FromCachedDataToVertexVector(mPointCloudSettings.filePath, tempVertices, mPointCloudSettings.usingColors, mPointCloudSettings.threadCount);
+	}
+	else
+	{
+		ReadWriteFiles::FromDataToVertexVector(mPointCloudSettings.filePath, tempVertices, mPointCloudSettings.usingColors, mPointCloudSettings.threadCount);
+	}
 
-	// Finding min and max for x and z
-	float minVertX = tempVertices[0].mPosition.x;
-	float maxVertX = tempVertices[0].mPosition.x;
-	float minVertZ = tempVertices[0].mPosition.z;
-	float maxVertZ = tempVertices[0].mPosition.z;
+	// Optional subsampling, keeps one averaged point per voxel
+	VoxelGridFilter::Downsample(tempVertices, mPointCloudSettings.voxelSize, mPointCloudSettings.usingColors, mPointCloudSettings.threadCount);
+
+	BuildTerrainFromVertices(resolution, usingBSpling, tempVertices, cloudScale);
+}
 
-	for (const auto& vertex : tempVertices)
+void Mesh::BuildTerrainFromVertices(int resolution, bool usingBSpling, std::vector<Vertex>& tempVertices, glm::vec3 cloudScale)
+{
+	if (tempVertices.empty())
 	{
-		minVertX = std::min(minVertX, vertex.mPosition.x);
-		maxVertX = std::max(maxVertX, vertex.mPosition.x);
-		minVertZ = std::min(minVertZ, vertex.mPosition.z);
-		maxVertZ = std::max(maxVertZ, vertex.mPosition.z);
+		std::cerr << "No points to build the terrain from" << std::endl;
+		return;
 	}
-	std::cout << "Min and Max found for x and z\n";
+
+	// Gathering x and z into separate arrays, the bounds and recentering kernels run over these
+	std::vector<float> pointX(tempVertices.size());
+	std::vector<float> pointZ(tempVertices.size());
+	for (size_t i = 0; i < tempVertices.size(); ++i)
+	{
+		pointX[i] = tempVertices[i].mPosition.x;
+		pointZ[i] = tempVertices[i].mPosition.z;
+	}
+
+	// Finding min and max for x and z
+	PointBoundsXZ bounds = PointKernels::ComputeBounds(pointX.data(), pointZ.data(), pointX.size());
+	float minVertX = bounds.minX;
+	float maxVertX = bounds.maxX;
+	float minVertZ = bounds.minZ;
+	float maxVertZ = bounds.maxZ;
+	std::cout << "Min and Max found for x and z (" << PointKernels::GetKernelSetName() << " kernels)\n";
 
 	// Calculating the midpoint and recenter vertices
 	float midPointX = (minVertX + maxVertX) / 2.f;
 	float midPointZ = (minVertZ + maxVertZ) / 2.f;
 
-	for (auto& vertex : tempVertices)
-	{
-		vertex.mPosition.x -= midPointX;
-		vertex.mPosition.z -= midPointZ;
-	}
-
+	// Only the x and z arrays are recentered, writing them back into the vertices would cost another pass over every vertex
+	PointKernels::Translate(pointX.data(), pointZ.data(), pointX.size(), midPointX, midPointZ);
 	std::cout << "Vertices recentered\n";
 
+	BuildTerrainFromPoints(resolution, usingBSpling, RecenteredVertexPointSource{ tempVertices, pointX, pointZ }, minVertX, maxVertX, minVertZ, maxVertZ, cloudScale);
+	FinishTerrainGrid(resolution);
+}
+
+template <typename PointSource>
+void Mesh::BuildTerrainFromPoints(int resolution, bool usingBSpling, const PointSource& points, float minVertX, float maxVertX, float minVertZ, float maxVertZ, glm::vec3 cloudScale)
+{
 	if (usingBSpling)
 	{
 		// Calculate grid dimensions based on resolution
@@ -465,22 +687,9 @@ void Mesh::CreateMeshFromPointCloud(int resolution, bool usingBSpling, glm::vec3
 		std::vector<std::vector<Vertex>> controlPoints(gridWidth, std::vector<Vertex>(gridHeight, Vertex(0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f)));
 
 		// Populate the control points grid
-		for (const auto& vertex : tempVertices) {
-			int i = static_cast<int>((vertex.mPosition.x - minVertX) / xSpacing);
-			int j = static_cast<int>((vertex.mPosition.z - minVertZ) / zSpacing);
-
-			i = std::clamp(i, 0, gridWidth - 1);
-			j = std::clamp(j, 0, gridHeight - 1);
-
-			if (controlPoints[i][j].mPosition == glm::vec3(0.0f))
-			{
-				controlPoints[i][j] = vertex;
-			}
-			else
-			{
-				controlPoints[i][j].mPosition = (controlPoints[i][j].mPosition + vertex.mPosition) / 2.0f;
-				controlPoints[i][j].mColor = (controlPoints[i][j].mColor + vertex.mColor) / 2.0f;
-			}
+		for (size_t index = 0; index < points.GetPointCount(); ++index)
+		{
+			AddSplineControlPoint(controlPoints, points.GetVertex(index), minVertX, minVertZ, xSpacing, zSpacing);
 		}
 
 		// Generate the spline surface
@@ -489,9 +698,74 @@ void Mesh::CreateMeshFromPointCloud(int resolution, bool usingBSpling, glm::vec3
 	else
 	{
 		// Generating and Populating the grid
-		GenerateAndPopulateGrid(resolution, tempVertices, minVertX, maxVertX, minVertZ, maxVertZ, cloudScale);
+		PopulateGridFromPoints(resolution, points, minVertX, maxVertX, minVertZ, maxVertZ, cloudScale);
 		std::cout << "Grid generated and populated\n";
 	}
+}
+
+void Mesh::StartAsyncTerrainLoad(int resolution, bool usingBSpling, glm::vec3 cloudScale)
+{
+	// Coarse preview from a sample of the points, this is what is shown until the full terrain is ready
+	auto startTime = std::chrono::high_resolution_clock::now();
+	std::vector<Vertex> sampledVertices;
+	ReadWriteFiles::SamplePointsFromFile(mPointCloudSettings.filePath, sampledVertices, mPointCloudSettings.usingColors, mPointCloudSettings.previewPointCount);
+	BuildTerrainFromVertices(std::min(resolution, 32), false, sampledVertices, cloudScale);
+	std::chrono::duration<double> elapsedTime = std::chrono::high_resolution_clock::now() - startTime;
+	std::cout << "Terrain preview from " << sampledVertices.size() << " points built in " << elapsedTime.count() << " s\n";
+
+	// The full terrain is built into its own mesh on a worker thread, FinishAsyncTerrainLoad() swaps it in
+	PointCloudSettings fullSettings = mPointCloudSettings;
+	fullSettings.asyncLoading = false;
+	mAsyncLoadStart = std::chrono::high_resolution_clock::now();
+	mPendingTerrain = std::async(std::launch::async, [fullSettings, resolution, usingBSpling, cloudScale]()
+		{
+			return std::make_unique<Mesh>(fullSettings, resolution, usingBSpling, cloudScale);
+		});
+}
+
+bool Mesh::FinishAsyncTerrainLoad()
+{
+	if (!mPendingTerrain.valid() || mPendingTerrain.wait_for(std::chrono::seconds(0)) != std::future_status::ready) return false;
+
+	// The future is used up after get(), a failed load keeps the preview for good, so the reason is logged here
+	std::unique_ptr<Mesh> fullTerrain;
+	try
+	{
+		fullTerrain = mPendingTerrain.get();
+	}
+	catch (const std::exception& exception)
+	{
+		std::cerr << "Full resolution terrain failed to load, keeping the preview: " << exception.what() << std::endl;
+		return false;
+	}
+	if (!fullTerrain || fullTerrain->mVertices.empty())
+	{
+		std::cerr << "Full resolution terrain from " << mPointCloudSettings.filePath << " has no points, keeping the preview" << std::endl;
+		return false;
+	}
+
+	mVertices.swap(fullTerrain->mVertices);
+	mIndices.swap(fullTerrain->mIndices);
+	customArea.swap(fullTerrain->customArea);
+	mTerrainTiles.swap(fullTerrain->mTerrainTiles);
+	mGridResolution = fullTerrain->mGridResolution;
+	mHeightfield = fullTerrain->mHeightfield;
+	mVisibleIndexRanges.clear();
+	mHasCulledTiles = false;
+	ResetTriangleQueries();
+	minTerrainLimit = fullTerrain->minTerrainLimit;
+	maxTerrainLimit = fullTerrain->maxTerrainLimit;
+	UploadMeshData();
+
+	std::chrono::duration<double> elapsedTime = std::chrono::high_resolution_clock::now() - mAsyncLoadStart;
+	std::cout << "Full resolution terrain swapped in after " << elapsedTime.count() << " s\n";
+	return true;
+}
+
+void Mesh::FinishTerrainGrid(int resolution)
+{
+	mGridResolution = resolution;
+	ResetTriangleQueries();
 
 	// Triangulate the grid
 	TriangulateGrid(resolution, resolution, mIndices);
@@ -501,6 +775,26 @@ void Mesh::CreateMeshFromPointCloud(int resolution, bool usingBSpling, glm::vec3
 	CalculateNormals();
 	std::cout << "Triangulated vertices normal calculated\n";
 
+	// Splitting the triangles into tiles for frustum culling
+	BuildTerrainTiles(resolution);
+
+	// Optional quadric simplification, the tile and custom area borders are kept as they are
+	if (mPointCloudSettings.simplifyTargetTriangles > 0 || mPointCloudSettings.simplifyMaxHeightError > 0.f)
+	{
+		SimplifyTerrain({ mPointCloudSettings.simplifyTargetTriangles, mPointCloudSettings.simplifyMaxHeightError });
+	}
+
+	// Heights and normals for the terrain queries, kept apart from the render vertices
+	// Only the full grid matches the heightfield, a simplified mesh is queried through its own triangles so objects rest on what is drawn
+	if (mIndices.size() == static_cast<size_t>(resolution - 1) * (resolution - 1) * 6)
+	{
+		mHeightfield = std::make_shared<const TerrainHeightfield>(mVertices, resolution);
+	}
+	else
+	{
+		mHeightfield.reset();
+	}
+
 	// Storing terrain min and max limits from the new mVertices vector
 	for (const auto& vertices : mVertices)
 	{
@@ -513,7 +807,184 @@ void Mesh::CreateMeshFromPointCloud(int resolution, bool usingBSpling, glm::vec3
 	std::cout << "Max x: " << maxTerrainLimit.x << "Max y: " << maxTerrainLimit.y << "Max z: " << maxTerrainLimit.z << "\n";
 }
 
+void Mesh::StreamPointCloudIntoGrid(int resolution, bool usingBSpling, glm::vec3 cloudScale)
+{
+	const std::string& filePath = mPointCloudSettings.filePath;
+	const bool usingColors = mPointCloudSettings.usingColors;
+
+	// Both passes read the binary cache when it is enabled, which is a lot cheaper than parsing the text twice
+	if (mPointCloudSettings.useBinaryCache && !PointCloudCache::IsBinaryPointFile(filePath) && !LasReader::IsLasFile(filePath))
+	{
+		ReadWriteFiles::WritePointCloudCacheFromText(filePath, usingColors);
+	}
+
+	// First pass, finding min and max for x and z
+	float minVertX = std::numeric_limits<float>::max();
+	float maxVertX = std::numeric_limits<float>::lowest();
+	float minVertZ = std::numeric_limits<float>::max();
+	float maxVertZ = std::numeric_limits<float>::lowest();
+	size_t pointCount = 0;
+
+	ReadWriteFiles::ForEachPointInFile(filePath, usingColors, [&](const Vertex& vertex)
+		{
+			minVertX = std::min(minVertX, vertex.mPosition.x);
+			maxVertX = std::max(maxVertX, vertex.mPosition.x);
+			minVertZ = std::min(minVertZ, vertex.mPosition.z);
+			maxVertZ = std::max(maxVertZ, vertex.mPosition.z);
+			pointCount++;
+		});
+	if (pointCount == 0)
+	{
+		std::cerr << "No points found in: " << filePath << std::endl;
+		return;
+	}
+	std::cout << "Min and Max found for x and z over " << pointCount << " points\n";
+
+	// The points are recentered as they are read in the second pass
+	float midPointX = (minVertX + maxVertX) / 2.f;
+	float midPointZ = (minVertZ + maxVertZ) / 2.f;
+
+	if (usingBSpling)
+	{
+		// Same control point fill as the in-memory path
+		float xSpacing = (maxVertX - minVertX) / (resolution - 1);
+		float zSpacing = (maxVertZ - minVertZ) / (resolution - 1);
+		std::vector<std::vector<Vertex>> controlPoints(resolution, std::vector<Vertex>(resolution, Vertex(0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f)));
+
+		ReadWriteFiles::ForEachPointInFile(filePath, usingColors, [&](const Vertex& vertex)
+			{
+				Vertex recentered = vertex;
+				recentered.mPosition.x -= midPointX;
+				recentered.mPosition.z -= midPointZ;
+				AddSplineControlPoint(controlPoints, recentered, minVertX, minVertZ, xSpacing, zSpacing);
+			});
+
+		GenerateSplineSurface(resolution, controlPoints);
+		return;
+	}
+
+	// Same sample layout as GenerateAndPopulateGrid
+	float gridWidth = maxVertX - minVertX;
+	float gridHeight = maxVertZ - minVertZ;
+	float xSpacing = gridWidth / static_cast<float>(resolution - 1);
+	float zSpacing = gridHeight / static_cast<float>(resolution - 1);
+	float cellSize = std::min(xSpacing, zSpacing);
+	float halfBox = cellSize / 2.f;
+
+	// Per sample sums and counts, this is all the memory the streaming grid needs
+	size_t sampleCount = static_cast<size_t>(resolution) * resolution;
+	std::vector<float> sumY(sampleCount, 0.f);
+	std::vector<glm::vec3> sumColor(sampleCount, glm::vec3(0.f));
+	std::vector<unsigned int> pointsInSample(sampleCount, 0);
+
+	// Second pass, adding each point to every sample box it falls inside
+	ReadWriteFiles::ForEachPointInFile(filePath, usingColors, [&](const Vertex& vertex)
+		{
+			float x = vertex.mPosition.x - midPointX;
+			float z = vertex.mPosition.z - midPointZ;
+
+			// The boxes are at most one spacing wide, so only the nearest one or two samples per axis can contain the point
+			int firstI = std::max(static_cast<int>(std::floor((x - halfBox + gridWidth / 2.f) / xSpacing)), 0);
+			int lastI = std::min(static_cast<int>(std::floor((x + halfBox + gridWidth / 2.f) / xSpacing)) + 1, resolution - 1);
+			int firstJ = std::max(static_cast<int>(std::floor((z - halfBox + gridHeight / 2.f) / zSpacing)), 0);
+			int lastJ = std::min(static_cast<int>(std::floor((z + halfBox + gridHeight / 2.f) / zSpacing)) + 1, resolution - 1);
+
+			for (int i = firstI; i <= lastI; ++i)
+			{
+				float posX = -gridWidth / 2.f + i * xSpacing;
+				if (x < posX - halfBox || x > posX + halfBox) continue;
+
+				for (int j = firstJ; j <= lastJ; ++j)
+				{
+					float posZ = -gridHeight / 2.f + j * zSpacing;
+					if (z < posZ - halfBox || z > posZ + halfBox) continue;
+
+					size_t sample = static_cast<size_t>(i) * resolution + j;
+					sumY[sample] += vertex.mPosition.y;
+					sumColor[sample] += vertex.mColor;
+					pointsInSample[sample]++;
+				}
+			}
+		});
+	std::cout << "Grid populated from stream\n";
+
+	// Custom area for friction
+	customArea.emplace_back(glm::vec3{ -40.0f, 0.0f, 0.0f }, glm::vec3{ -30.0f, 0.0f, 10.0f }, glm::vec3{ 0.0f, 0.0f, 1.0f }, 0.5f);
+
+	size_t firstVertex = mVertices.size();
+	mVertices.resize(firstVertex + sampleCount, Vertex(0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f));
+	RunOverGridRows(resolution, mPointCloudSettings.threadCount, "Grid generation", [&](int i)
+	{
+		float posX = -gridWidth / 2.f + i * xSpacing;
+		for (int j = 0; j < resolution; ++j)
+		{
+			float posZ = -gridHeight / 2.f + j * zSpacing;
+			size_t sample = static_cast<size_t>(i) * resolution + j;
+
+			float avgY = 0.0f;
+			glm::vec3 avgColor(1.0f, 1.0f, 1.0f);
+			if (pointsInSample[sample] > 0)
+			{
+				avgY = sumY[sample] / pointsInSample[sample];
+				avgColor = sumColor[sample] / static_cast<float>(pointsInSample[sample]);
+			}
+			SetGridSample(firstVertex + sample, posX, posZ, avgY, avgColor, cloudScale);
+		}
+	});
+	std::cout << "Grid generated and populated\n";
+}
+
+void Mesh::AddSplineControlPoint(std::vector<std::vector<Vertex>>& controlPoints, const Vertex& vertex, float minVertX, float minVertZ, float xSpacing, float zSpacing)
+{
+	int gridWidth = controlPoints.size();
+	int gridHeight = controlPoints[0].size();
+
+	int i = static_cast<int>((vertex.mPosition.x - minVertX) / xSpacing);
+	int j = static_cast<int>((vertex.mPosition.z - minVertZ) / zSpacing);
+
+	i = std::clamp(i, 0, gridWidth - 1);
+	j = std::clamp(j, 0, gridHeight - 1);
+
+	if (controlPoints[i][j].mPosition == glm::vec3(0.0f))
+	{
+		controlPoints[i][j] = vertex;
+	}
+	else
+	{
+		controlPoints[i][j].mPosition = (controlPoints[i][j].mPosition + vertex.mPosition) / 2.0f;
+		controlPoints[i][j].mColor = (controlPoints[i][j].mColor + vertex.mColor) / 2.0f;
+	}
+}
+
+void Mesh::SetGridSample(size_t vertexIndex, float posX, float posZ, float avgY, glm::vec3 avgColor, glm::vec3 cloudScale)
+{
+	// Check if the current position is within the custom area
+	for (const auto& area : customArea)
+	{
+		if (posX >= area.minBounds.x && posX <= area.maxBounds.x &&
+			posZ >= area.minBounds.z && posZ <= area.maxBounds.z)
+		{
+			avgColor = area.color;
+			//terrainFriction = area.areaFriction;
+		}
+	}
+
+	// Store the averaged vertex in its grid slot
+	mVertices[vertexIndex] = Vertex(posX * cloudScale.x, avgY * cloudScale.y, posZ * cloudScale.z, avgColor.r, avgColor.g, avgColor.b);
+}
+
 void Mesh::GenerateAndPopulateGrid(int resolution, std::vector<Vertex>& tempVertices, float minVertX, float maxVertX, float minVertZ, float maxVertZ, glm::vec3 cloudScale)
+{
+	PopulateGridFromPoints(resolution, VertexPointSource{ tempVertices }, minVertX, maxVertX, minVertZ, maxVertZ, cloudScale);
+}
+
+void Mesh::GenerateAndPopulateGrid(int resolution, const CompactPointCloud& points, float minVertX, float maxVertX, float minVertZ, float maxVertZ, glm::vec3 cloudScale)
+{
+	PopulateGridFromPoints(resolution, points, minVertX, maxVertX, minVertZ, maxVertZ, cloudScale);
+}
+
+template <typename PointSource>
+void Mesh::PopulateGridFromPoints(int resolution, const PointSource& points, float minVertX, float maxVertX, float minVertZ, float maxVertZ, glm::vec3 cloudScale)
 {
 	std::cout << "Starting grid calculations with resolution: " << resolution << "\n";
 	// Calculate the width and height of the grid
@@ -531,27 +1002,34 @@ void Mesh::GenerateAndPopulateGrid(int resolution, std::vector<Vertex>& tempVert
 	int cellsZ = static_cast<int>(std::ceil(gridHeight / cellSize));
 	std::cout << "Grid calculations complete\n";
 
-	// Create a 3D vector to hold vertices in each grid cell
-	std::vector<std::vector<std::vector<Vertex>>> gridVector(cellsX, std::vector<std::vector<Vertex>>(cellsZ));
-
-	// Populate the grid with vertices based on their positions
-	for (const auto& vertex : tempVertices)
+	// Binning the point indices into a flat cell index, cells are counted from the minimum corner of the recentered points
+	auto binningStart = std::chrono::high_resolution_clock::now();
+	CellBinIndex cellBins;
+	if constexpr (requires { points.GetPointsX(); })
 	{
-		// Determine the cell indices for the current vertex
-		int cellX = std::clamp(static_cast<int>(std::floor(vertex.mPosition.x / cellSize)), 0, cellsX - 1);
-		int cellZ = std::clamp(static_cast<int>(std::floor(vertex.mPosition.z / cellSize)), 0, cellsZ - 1);
-		gridVector[cellX][cellZ].emplace_back(vertex);
+		cellBins.Build(points.GetPointsX(), points.GetPointsZ(), points.GetPointCount(), -gridWidth / 2.f, -gridHeight / 2.f, cellSize, cellsX, cellsZ);
 	}
-	std::cout << "Grid populated\n";
+	else
+	{
+		cellBins.Build(points.GetPointCount(), [&](size_t index) { return points.GetPosition(index); }, -gridWidth / 2.f, -gridHeight / 2.f, cellSize, cellsX, cellsZ);
+	}
+	const std::vector<uint32_t>& binnedPoints = cellBins.GetBinnedPoints();
+	const std::vector<float>& binnedX = cellBins.GetBinnedX();
+	const std::vector<float>& binnedZ = cellBins.GetBinnedZ();
+	std::chrono::duration<double> binningTime = std::chrono::high_resolution_clock::now() - binningStart;
+	std::cout << "Grid populated with " << points.GetPointCount() << " points in " << binningTime.count() << " s\n";
 
 	// Custom area for friction
 	customArea.emplace_back(glm::vec3{ -40.0f, 0.0f, 0.0f }, glm::vec3{ -30.0f, 0.0f, 10.0f }, glm::vec3{ 0.0f, 0.0f, 1.0f }, 0.5f);
 
-	// Iterate over the grid to calculate average positions and colors
-	for (int i = 0; i < resolution; ++i)
+	// Iterate over the grid rows in parallel to calculate average positions and colors
+	size_t firstVertex = mVertices.size();
+	mVertices.resize(firstVertex + static_cast<size_t>(resolution) * resolution, Vertex(0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f));
+	RunOverGridRows(resolution, mPointCloudSettings.threadCount, "Grid generation", [&](int i)
 	{
 		// Calculate the X position for the grid cell
 		float posX = -gridWidth / 2.f + i * xSpacing;
+		SampleAccumulator sample;
 		for (int j = 0; j < resolution; ++j)
 		{
 			// Calculate the Z position for the grid cell
@@ -564,76 +1042,36 @@ void Mesh::GenerateAndPopulateGrid(int resolution, std::vector<Vertex>& tempVert
 			float boxMaxZ = posZ + halfBox;
 
 			// Determine the range of cells that intersect with the bounding box
-			int minCellX = std::clamp(static_cast<int>(std::floor(boxMinX / cellSize)), 0, cellsX - 1);
-			int maxCellX = std::clamp(static_cast<int>(std::floor(boxMaxX / cellSize)), 0, cellsX - 1);
-			int minCellZ = std::clamp(static_cast<int>(std::floor(boxMinZ / cellSize)), 0, cellsZ - 1);
-			int maxCellZ = std::clamp(static_cast<int>(std::floor(boxMaxZ / cellSize)), 0, cellsZ - 1);
+			int minCellX = cellBins.GetCellX(boxMinX);
+			int maxCellX = cellBins.GetCellX(boxMaxX);
+			int minCellZ = cellBins.GetCellZ(boxMinZ);
+			int maxCellZ = cellBins.GetCellZ(boxMaxZ);
 
-			// Vectors to hold Y values and color components
-			std::vector<float> yValues, rValues, gValues, bValues;
+			// Running sums of the heights and colors inside the bounding box
+			sample.Reset();
 
-			// Collect data from the intersecting cells
+			// Collect data from the intersecting cells, the cells along z of one cell column are a single contiguous range
 			for (int cellX = minCellX; cellX <= maxCellX; ++cellX)
 			{
-				for (int cellZ = minCellZ; cellZ <= maxCellZ; ++cellZ)
+				size_t rangeEnd = cellBins.GetRangeEnd(cellX, maxCellZ);
+				for (size_t binned = cellBins.GetRangeBegin(cellX, minCellZ); binned < rangeEnd; ++binned)
 				{
-					for (const auto& dataVertex : gridVector[cellX][cellZ])
-					{
-						// Check if the vertex is within the bounding box
-						if (dataVertex.mPosition.x >= boxMinX && dataVertex.mPosition.x <= boxMaxX &&
-							dataVertex.mPosition.z >= boxMinZ && dataVertex.mPosition.z <= boxMaxZ) {
-							yValues.push_back(dataVertex.mPosition.y);
-							rValues.push_back(dataVertex.mColor.r);
-							gValues.push_back(dataVertex.mColor.g);
-							bValues.push_back(dataVertex.mColor.b);
-						}
+					// Check if the point is within the bounding box
+					if (binnedX[binned] >= boxMinX && binnedX[binned] <= boxMaxX &&
+						binnedZ[binned] >= boxMinZ && binnedZ[binned] <= boxMaxZ) {
+						sample.AddPoint(points.GetPosition(binnedPoints[binned]).y, points.GetColor(binnedPoints[binned]));
 					}
 				}
 			}
 
-			// Calculate the average Y position
-			float avgY;
-			if (!yValues.empty())
-			{
-				avgY = std::accumulate(yValues.begin(), yValues.end(), 0.0f) / yValues.size();
-			}
-			else
-			{
-				avgY = 0.0f;
-			}
-
-			// Calculate the average color
-			glm::vec3 avgColor;
-			if (!rValues.empty())
-			{
-				avgColor = glm::vec3(
-					std::accumulate(rValues.begin(), rValues.end(), 0.0f) / rValues.size(),
-					std::accumulate(gValues.begin(), gValues.end(), 0.0f) / gValues.size(),
-					std::accumulate(bValues.begin(), bValues.end(), 0.0f) / bValues.size()
-				);
-			}
-			else
-			{
-				avgColor = glm::vec3(1.0f, 1.0f, 1.0f);
-			}
+			// Average height and color, samples without points keep a flat white vertex
+			float avgY = sample.GetMeanHeight(0.0f);
+			glm::vec3 avgColor = sample.GetMeanColor(glm::vec3(1.0f, 1.0f, 1.0f));
 
-			// Check if the current position is within the custom area
-			for (const auto& area : customArea)
-			{
-				if (posX >= area.minBounds.x && posX <= area.maxBounds.x &&
-					posZ >= area.minBounds.z && posZ <= area.maxBounds.z)
-				{
-					avgColor = area.color;
-					//terrainFriction = area.areaFriction;
-				}
-			}
-
-			// Add the averaged vertex to the mesh
-			mVertices.emplace_back(posX * cloudScale.x, avgY * cloudScale.y, posZ * cloudScale.z, avgColor.r, avgColor.g, avgColor.b);
+			// Applying the custom area color and adding the averaged vertex to the mesh
+			SetGridSample(firstVertex + static_cast<size_t>(i) * resolution + j, posX, posZ, avgY, avgColor, cloudScale);
 		}
-		int percentageComplete = (i / static_cast<float>(resolution)) * 100;
-		std::cout << "Grid generation " << percentageComplete << "% complete" << "\n";
-	}
+	});
 }
 
 void Mesh::TriangulateGrid(int gridWidth, int gridHeight, std::vector<Index>& indices)
@@ -707,10 +1145,10 @@ void Mesh::GenerateSplineSurface(int resolution, const std::vector<std::vector<V
 	int gridWidth = controlPoints.size();
 	int gridHeight = controlPoints[0].size();
 
-	mVertices.clear();
+	mVertices.assign(static_cast<size_t>(resolution) * resolution, Vertex(0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f));
 
-	// Evaluate the spline surface at each grid point
-	for (int i = 0; i < resolution; ++i) {
+	// Evaluate the spline surface at each grid point, the rows are independent and run in parallel
+	RunOverGridRows(resolution, mPointCloudSettings.threadCount, "Spline surface evaluation", [&](int i) {
 		float u = i / static_cast<float>(resolution - 1);
 		for (int j = 0; j < resolution; ++j) {
 			float v = j / static_cast<float>(resolution - 1);
@@ -731,9 +1169,262 @@ void Mesh::GenerateSplineSurface(int resolution, const std::vector<std::vector<V
 				}
 			}
 
-			mVertices.emplace_back(position.x, position.y, position.z, color.r, color.g, color.b);
+			mVertices[static_cast<size_t>(i) * resolution + j] = Vertex(position.x, position.y, position.z, color.r, color.g, color.b);
 		}
+	});
+}
+
+void Mesh::BuildTerrainTiles(int resolution)
+{
+	mTerrainTiles.clear();
+	mVisibleIndexRanges.clear();
+	mHasCulledTiles = false;
+
+	int tileSize = mPointCloudSettings.tileSize;
+	int cellsPerSide = resolution - 1;
+	if (tileSize <= 0 || cellsPerSide <= 0 || mIndices.size() != static_cast<size_t>(cellsPerSide) * cellsPerSide * 6) return;
+
+	// Reordering the triangles tile by tile, the normals are already calculated so only the draw order changes
+	std::vector<Index> tiledIndices;
+	tiledIndices.reserve(mIndices.size());
+	for (int tileX = 0; tileX < cellsPerSide; tileX += tileSize)
+	{
+		for (int tileZ = 0; tileZ < cellsPerSide; tileZ += tileSize)
+		{
+			int endX = std::min(tileX + tileSize, cellsPerSide);
+			int endZ = std::min(tileZ + tileSize, cellsPerSide);
+
+			TerrainTile tile;
+			tile.firstIndex = tiledIndices.size();
+			for (int i = tileX; i < endX; ++i)
+			{
+				// TriangulateGrid writes 6 indices per cell, row by row
+				size_t firstCellIndex = (static_cast<size_t>(i) * cellsPerSide + tileZ) * 6;
+				size_t lastCellIndex = (static_cast<size_t>(i) * cellsPerSide + endZ) * 6;
+				tiledIndices.insert(tiledIndices.end(), mIndices.begin() + firstCellIndex, mIndices.begin() + lastCellIndex);
+			}
+			tile.indexCount = tiledIndices.size() - tile.firstIndex;
+
+			// Bounding box over every vertex the tile's cells use, the far edge row and column included
+			tile.minBounds = glm::vec3(std::numeric_limits<float>::max());
+			tile.maxBounds = glm::vec3(std::numeric_limits<float>::lowest());
+			for (int i = tileX; i <= endX; ++i)
+			{
+				for (int j = tileZ; j <= endZ; ++j)
+				{
+					const glm::vec3& position = mVertices[static_cast<size_t>(i) * resolution + j].mPosition;
+					tile.minBounds = glm::min(tile.minBounds, position);
+					tile.maxBounds = glm::max(tile.maxBounds, position);
+				}
+			}
+			mTerrainTiles.push_back(tile);
+		}
+	}
+	mIndices.swap(tiledIndices);
+	std::cout << "Terrain split into " << mTerrainTiles.size() << " tiles of " << tileSize << "x" << tileSize << " cells\n";
+}
+
+void Mesh::CullTerrainTiles(const glm::mat4& modelViewProjection)
+{
+	if (mTerrainTiles.empty()) return;
+
+	Frustum frustum(modelViewProjection);
+	mVisibleIndexRanges.clear();
+	mCullingStats.tilesDrawn = 0;
+	mCullingStats.tilesCulled = 0;
+	mCullingStats.indicesDrawn = 0;
+	for (const auto& tile : mTerrainTiles)
+	{
+		if (!frustum.IntersectsBox(tile.minBounds, tile.maxBounds))
+		{
+			mCullingStats.tilesCulled++;
+			continue;
+		}
+
+		// Tiles next to each other in the index buffer are merged into one range
+		if (!mVisibleIndexRanges.empty() && mVisibleIndexRanges.back().first + mVisibleIndexRanges.back().second == tile.firstIndex)
+		{
+			mVisibleIndexRanges.back().second += tile.indexCount;
+		}
+		else
+		{
+			mVisibleIndexRanges.emplace_back(tile.firstIndex, tile.indexCount);
+		}
+		mCullingStats.tilesDrawn++;
+		mCullingStats.indicesDrawn += tile.indexCount;
+	}
+	mCullingStats.drawCalls = mVisibleIndexRanges.size();
+	mCullingStats.totalTilesDrawn += mCullingStats.tilesDrawn;
+	mCullingStats.totalTilesCulled += mCullingStats.tilesCulled;
+	mCullingStats.culledFrames++;
+	mHasCulledTiles = true;
+}
+
+void Mesh::UpdateTerrainView(const glm::mat4& modelViewProjection, const glm::vec3& cameraPosition)
+{
+	if (mTerrainRenderer)
+	{
+		mTerrainRenderer->SelectNodes(modelViewProjection, cameraPosition);
+	}
+	else
+	{
+		CullTerrainTiles(modelViewProjection);
+	}
+}
+
+SimplifyStats Mesh::SimplifyTerrain(const SimplifySettings& settings)
+{
+	SimplifyStats stats;
+	const int resolution = mGridResolution;
+	if (resolution <= 1 || mVertices.size() != static_cast<size_t>(resolution) * resolution)
+	{
+		std::cerr << "Terrain simplification needs a terrain grid" << std::endl;
+		return stats;
+	}
+
+	// Only the index buffer changes, a mesh that is already uploaded needs UploadMeshData() afterwards
+	std::vector<uint8_t> lockedVertices;
+	LockTerrainBorders(lockedVertices);
+	stats = MeshSimplifier::Simplify(mVertices, resolution, mIndices, lockedVertices, settings);
+	if (stats.outputTriangles != stats.inputTriangles)
+	{
+		// The heightfield describes the full grid, queries fall back to the triangle lookups once triangles are merged
+		mHeightfield.reset();
+	}
+	ResetTriangleQueries();
+	MeshSimplifier::MeasureGridHeightError(mVertices, resolution, mIndices, stats.maxHeightError, stats.rmsHeightError);
+
+	// Grouping the remaining triangles by tile again, tile borders are locked so every triangle still lies inside one tile
+	int tileSize = mPointCloudSettings.tileSize;
+	if (!mTerrainTiles.empty() && tileSize > 0)
+	{
+		int tilesPerSide = (resolution - 1 + tileSize - 1) / tileSize;
+		std::vector<size_t> tileOfTriangle(mIndices.size() / 3);
+		std::vector<size_t> tileIndexCounts(mTerrainTiles.size(), 0);
+		for (size_t triangle = 0; triangle < tileOfTriangle.size(); ++triangle)
+		{
+			Index minI = std::min({ mIndices[triangle * 3] / resolution, mIndices[triangle * 3 + 1] / resolution, mIndices[triangle * 3 + 2] / resolution });
+			Index minJ = std::min({ mIndices[triangle * 3] % resolution, mIndices[triangle * 3 + 1] % resolution, mIndices[triangle * 3 + 2] % resolution });
+			int tileX = std::min(static_cast<int>(minI) / tileSize, tilesPerSide - 1);
+			int tileZ = std::min(static_cast<int>(minJ) / tileSize, tilesPerSide - 1);
+			tileOfTriangle[triangle] = static_cast<size_t>(tileX) * tilesPerSide + tileZ;
+			tileIndexCounts[tileOfTriangle[triangle]] += 3;
+		}
+
+		size_t firstIndex = 0;
+		for (size_t tile = 0; tile < mTerrainTiles.size(); ++tile)
+		{
+			mTerrainTiles[tile].firstIndex = firstIndex;
+			mTerrainTiles[tile].indexCount = tileIndexCounts[tile];
+			firstIndex += tileIndexCounts[tile];
+		}
+
+		std::vector<Index> tiledIndices(mIndices.size());
+		std::vector<size_t> writeIndices(mTerrainTiles.size());
+		for (size_t tile = 0; tile < mTerrainTiles.size(); ++tile)
+		{
+			writeIndices[tile] = mTerrainTiles[tile].firstIndex;
+		}
+		for (size_t triangle = 0; triangle < tileOfTriangle.size(); ++triangle)
+		{
+			size_t& writeIndex = writeIndices[tileOfTriangle[triangle]];
+			std::copy(mIndices.begin() + triangle * 3, mIndices.begin() + triangle * 3 + 3, tiledIndices.begin() + writeIndex);
+			writeIndex += 3;
+		}
+		mIndices.swap(tiledIndices);
 	}
+	mVisibleIndexRanges.clear();
+	mHasCulledTiles = false;
+
+	double reduction = stats.inputTriangles > 0 ? 100.0 * (1.0 - static_cast<double>(stats.outputTriangles) / stats.inputTriangles) : 0.0;
+	std::cout << "Terrain simplified from " << stats.inputTriangles << " to " << stats.outputTriangles << " triangles (" << reduction << "% fewer) in " << stats.seconds << " s\n";
+	std::cout << "Height error against the grid, max: " << stats.maxHeightError << " RMS: " << stats.rmsHeightError << "\n";
+	return stats;
+}
+
+void Mesh::LockTerrainBorders(std::vector<uint8_t>& lockedVertices) const
+{
+	const int resolution = mGridResolution;
+	const int tileSize = mTerrainTiles.empty() ? 0 : mPointCloudSettings.tileSize;
+	lockedVertices.assign(mVertices.size(), 0);
+
+	// Which custom area each vertex is in, the last matching area wins like in SetGridSample()
+	std::vector<int> vertexAreas(mVertices.size(), -1);
+	for (size_t vertex = 0; vertex < mVertices.size() && !customArea.empty(); ++vertex)
+	{
+		const glm::vec3& position = mVertices[vertex].mPosition;
+		for (size_t area = 0; area < customArea.size(); ++area)
+		{
+			if (position.x >= customArea[area].minBounds.x && position.x <= customArea[area].maxBounds.x &&
+				position.z >= customArea[area].minBounds.z && position.z <= customArea[area].maxBounds.z)
+			{
+				vertexAreas[vertex] = static_cast<int>(area);
+			}
+		}
+	}
+
+	// The grid edge, the tile borders and both sides of every custom area border keep their vertices
+	for (int i = 0; i < resolution; ++i)
+	{
+		for (int j = 0; j < resolution; ++j)
+		{
+			size_t vertex = static_cast<size_t>(i) * resolution + j;
+			bool onGridEdge = i == 0 || j == 0 || i == resolution - 1 || j == resolution - 1;
+			bool onTileBorder = tileSize > 0 && (i % tileSize == 0 || j % tileSize == 0);
+			bool onAreaBorder = (i > 0 && vertexAreas[vertex - resolution] != vertexAreas[vertex]) ||
+				(i < resolution - 1 && vertexAreas[vertex + resolution] != vertexAreas[vertex]) ||
+				(j > 0 && vertexAreas[vertex - 1] != vertexAreas[vertex]) ||
+				(j < resolution - 1 && vertexAreas[vertex + 1] != vertexAreas[vertex]);
+			lockedVertices[vertex] = onGridEdge || onTileBorder || onAreaBorder;
+		}
+	}
+}
+
+const TriangleBinIndex& Mesh::GetTriangleIndex()
+{
+	if (!mTriangleIndex)
+	{
+		auto startTime = std::chrono::high_resolution_clock::now();
+		mTriangleIndex = std::make_unique<TriangleBinIndex>();
+		mTriangleIndex->Build(mVertices, mIndices);
+		std::chrono::duration<double> elapsedTime = std::chrono::high_resolution_clock::now() - startTime;
+		std::cout << "Triangle index over " << mIndices.size() / 3 << " triangles built in " << elapsedTime.count() << " s\n";
+	}
+	return *mTriangleIndex;
+}
+
+const TriangleAdjacency& Mesh::GetTriangleAdjacency()
+{
+	if (!mTriangleAdjacency)
+	{
+		auto startTime = std::chrono::high_resolution_clock::now();
+		mTriangleAdjacency = std::make_unique<TriangleAdjacency>();
+		mTriangleAdjacency->Build(mIndices);
+		std::chrono::duration<double> elapsedTime = std::chrono::high_resolution_clock::now() - startTime;
+		std::cout << "Triangle adjacency over " << mIndices.size() / 3 << " triangles built in " << elapsedTime.count() << " s\n";
+	}
+	return *mTriangleAdjacency;
+}
+
+const TriangleBVH& Mesh::GetTriangleBVH()
+{
+	if (!mTriangleBVH)
+	{
+		auto startTime = std::chrono::high_resolution_clock::now();
+		mTriangleBVH = std::make_unique<TriangleBVH>();
+		mTriangleBVH->Build(mVertices, mIndices);
+		std::chrono::duration<double> elapsedTime = std::chrono::high_resolution_clock::now() - startTime;
+		std::cout << "Triangle BVH over " << mIndices.size() / 3 << " triangles built in " << elapsedTime.count() << " s, "
+			<< mTriangleBVH->GetNodeCount() << " nodes, depth " << mTriangleBVH->GetDepth() << "\n";
+	}
+	return *mTriangleBVH;
+}
+
+void Mesh::ResetTriangleQueries()
+{
+	mTriangleIndex.reset();
+	mTriangleAdjacency.reset();
+	mTriangleBVH.reset();
 }
 
 std::pair<glm::vec3, glm::vec3> Mesh::CalculateBoxExtent()
@@ -768,4 +1459,10 @@ float Mesh::CalculateRadius()
 	float radius = (std::abs(maxExtent.x - minExtent.x) / 2);
 
 	return radius;
+}
+
+bool Mesh::ExportToPly(const std::string& filePath)
+{
+	// Binary PLY with positions, normals, colors and the triangle list, readable by most mesh tools
+	return ReadWriteFiles::WriteToPlyFile(filePath, mVertices, mIndices);
 }
\ No newline at end of file
@@ -1,10 +1,14 @@
 #pragma once
 #include <glad/glad.h>
 #include <glm/glm.hpp>
+#include <chrono>
+#include <future>
+#include <memory>
 #include <string>
 #include <vector>
 
 #include "utility/ICollisionBounds.h"
+#include "utility/MeshSimplifier.h"
 #include "shader/Shader.h"
 #include "utility/ReadWriteFiles.h"
 #include "utility/VariableTypes.h"
@@ -22,6 +26,13 @@ enum MeshShape
 	BSPLINE
 };
 
+class CompactPointCloud;
+class TerrainHeightfield;
+class TerrainRenderer;
+class TriangleBinIndex;
+class TriangleAdjacency;
+class TriangleBVH;
+
 class CustomArea
 {
 public:
@@ -39,6 +50,44 @@ public:
 	}
 };
 
+// Square block of terrain grid cells, its triangles are one contiguous range of the index buffer
+struct TerrainTile
+{
+	size_t firstIndex{ 0 };
+	size_t indexCount{ 0 };
+	glm::vec3 minBounds{ 0.f };
+	glm::vec3 maxBounds{ 0.f };
+};
+
+// Counters from the last CullTerrainTiles() call, plus running totals
+struct TerrainCullingStats
+{
+	size_t tilesDrawn{ 0 };
+	size_t tilesCulled{ 0 };
+	size_t drawCalls{ 0 };
+	size_t indicesDrawn{ 0 };
+	size_t totalTilesDrawn{ 0 };
+	size_t totalTilesCulled{ 0 };
+	size_t culledFrames{ 0 };
+};
+
+struct PointCloudSettings
+{
+	std::string filePath{ "TerrainData.txt" }; // Text point cloud, a binary .las file, or a .pcbin file written by the PointCloudTool
+	bool usingColors{ true };
+	unsigned int threadCount{ 0 }; // 0 uses every hardware thread, 1 runs the serial loader
+	bool useBinaryCache{ true }; // Writes/reads a binary copy of a text file next to it (filePath + ".pcbin")
+	bool streamingGrid{ false }; // Bins points straight from the file in two passes, memory scales with the resolution instead of the point count
+	bool compactPoints{ false }; // Holds the loaded points quantised to 16 bytes each (int32 position, RGB8 color) instead of full vertices
+	float voxelSize{ 0.f }; // Keeps one averaged point per voxel of this size after loading, 0 keeps every point (not used by streamingGrid)
+	bool asyncLoading{ false }; // Shows a coarse preview right away and builds the full terrain on a worker thread
+	size_t previewPointCount{ 20000 }; // Points sampled from the file for the preview
+	int tileSize{ 32 }; // Grid cells per side of a culling tile, 0 keeps the terrain as one draw without culling
+	bool heightmapRendering{ false }; // Draws the terrain from a height texture with CDLOD patches instead of the full vertex buffer
+	size_t simplifyTargetTriangles{ 0 }; // Simplifies the terrain mesh down to this many triangles, 0 has no triangle target
+	float simplifyMaxHeightError{ 0.f }; // Simplifies the terrain mesh while the quadric height error stays below this, 0 has no error bound
+};
+
 class Vertex
 {
 public:
@@ -99,9 +148,12 @@ public:
 	/*
 	 * Constructor, setup and render
 	 */
-	Mesh(MeshShape meshShape, Shader* meshShader);
+	Mesh(MeshShape meshShape, Shader* meshShader, const PointCloudSettings& pointCloudSettings = PointCloudSettings());
+	Mesh(const PointCloudSettings& pointCloudSettings, int resolution, bool usingBSpling, glm::vec3 cloudScale); // Terrain without GL setup, for worker threads
+	~Mesh();
 	void RenderMesh();
 	void MeshSetup();
+	void UploadMeshData();
 
 	/*
 	 * Mesh shapes
@@ -125,16 +177,54 @@ public:
 	 * Point Cloud Generation and Triangulation
 	 */
 	void CreateMeshFromPointCloud(int resolution, bool usingBSpling, glm::vec3 cloudScale);
+	void BuildTerrainFromVertices(int resolution, bool usingBSpling, std::vector<Vertex>& tempVertices, glm::vec3 cloudScale);
+	void StartAsyncTerrainLoad(int resolution, bool usingBSpling, glm::vec3 cloudScale);
+	bool FinishAsyncTerrainLoad();
 	void GenerateAndPopulateGrid(int resolution, std::vector<Vertex>& tempVertices, float minVertX, float maxVertX, float minVertZ, float maxVertZ, glm::vec3 cloudScale);
+	void GenerateAndPopulateGrid(int resolution, const CompactPointCloud& points, float minVertX, float maxVertX, float minVertZ, float maxVertZ, glm::vec3 cloudScale);
+	template <typename PointSource>
+	void BuildTerrainFromPoints(int resolution, bool usingBSpling, const PointSource& points, float minVertX, float maxVertX, float minVertZ, float maxVertZ, glm::vec3 cloudScale);
+	template <typename PointSource>
+	void PopulateGridFromPoints(int resolution, const PointSource& points, float minVertX, float maxVertX, float minVertZ, float maxVertZ, glm::vec3 cloudScale);
+	void StreamPointCloudIntoGrid(int resolution, bool usingBSpling, glm::vec3 cloudScale);
+	void AddSplineControlPoint(std::vector<std::vector<Vertex>>& controlPoints, const Vertex& vertex, float minVertX, float minVertZ, float xSpacing, float zSpacing);
+	void SetGridSample(size_t vertexIndex, float posX, float posZ, float avgY, glm::vec3 avgColor, glm::vec3 cloudScale);
+	void FinishTerrainGrid(int resolution);
 	void TriangulateGrid(int gridWidth, int gridHeight, std::vector<unsigned int>& indices);
 	void CalculateNormals();
 	void GenerateSplineSurface(int resolution, const std::vector<std::vector<Vertex>>& controlPoints);
 
+	/*
+	 * Terrain tiles and culling
+	 */
+	void BuildTerrainTiles(int resolution);
+	void CullTerrainTiles(const glm::mat4& modelViewProjection);
+	void UpdateTerrainView(const glm::mat4& modelViewProjection, const glm::vec3& cameraPosition);
+	const std::vector<TerrainTile>& GetTerrainTiles() const { return mTerrainTiles; }
+	const TerrainCullingStats& GetCullingStats() const { return mCullingStats; }
+
+	/*
+	 * Terrain simplification
+	 */
+	SimplifyStats SimplifyTerrain(const SimplifySettings& settings);
+	void LockTerrainBorders(std::vector<uint8_t>& lockedVertices) const;
+
+	/*
+	 * Terrain queries
+	 */
+	std::shared_ptr<const TerrainHeightfield> GetHeightfield() const { return mHeightfield; }
+	const TriangleBinIndex& GetTriangleIndex();
+	const TriangleAdjacency& GetTriangleAdjacency();
+	const TriangleBVH& GetTriangleBVH();
+	// Drops the lookups above, they are built again from the current buffers on the next call
+	void ResetTriangleQueries();
+
 	/*
 	* Mesh Utility
 	*/
 	std::pair<glm::vec3, glm::vec3> CalculateBoxExtent();
 	float CalculateRadius();
+	bool ExportToPly(const std::string& filePath);
 
 	/*
 	 * Member Variables
@@ -151,10 +241,23 @@ public:
 	Shader* mMeshShader;
 
 	/*Terrain settings*/
+	PointCloudSettings mPointCloudSettings;
 	bool setWireframe{ false };
 	glm::vec3 minTerrainLimit{ 0.f, 0.f, 0.f, };
 	glm::vec3 maxTerrainLimit{ 0.f, 0.f, 0.f, };
 	std::vector<CustomArea> customArea;
+	int mGridResolution{ 0 }; // Vertices per side of the terrain grid, 0 when the mesh is not a terrain grid
+	std::vector<TerrainTile> mTerrainTiles;
+	std::vector<std::pair<size_t, size_t>> mVisibleIndexRanges; // (first index, index count) per draw call, filled by CullTerrainTiles()
+	bool mHasCulledTiles{ false };
+	TerrainCullingStats mCullingStats;
+	std::unique_ptr<TerrainRenderer> mTerrainRenderer;
+	std::shared_ptr<const TerrainHeightfield> mHeightfield; // Replaced, never modified, when the terrain changes, so a query holding it can keep using it, empty for a simplified terrain
+	std::unique_ptr<TriangleBinIndex> mTriangleIndex; // Built on the first GetTriangleIndex() call, dropped by ResetTriangleQueries()
+	std::unique_ptr<TriangleAdjacency> mTriangleAdjacency; // Built on the first GetTriangleAdjacency() call, dropped by ResetTriangleQueries()
+	std::unique_ptr<TriangleBVH> mTriangleBVH; // Built on the first GetTriangleBVH() call, dropped by ResetTriangleQueries()
+	std::future<std::unique_ptr<Mesh>> mPendingTerrain;
+	std::chrono::high_resolution_clock::time_point mAsyncLoadStart;
 
 	/*BiQuadratic Spline Variables*/
 	float B0(float t) { return 0.5f * (1 - t) * (1 - t); }
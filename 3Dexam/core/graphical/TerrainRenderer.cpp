@@ -0,0 +1,275 @@
+#include "TerrainRenderer.h"
+
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include <glad/glad.h>
+
+#include "Mesh.h"
+#include "shader/Shader.h"
+#include "utility/Frustum.h"
+
+TerrainRenderer::~TerrainRenderer()
+{
+	if (mHeightTexture) glDeleteTextures(1, &mHeightTexture);
+	if (mColorTexture) glDeleteTextures(1, &mColorTexture);
+	if (mPatchEBO) glDeleteBuffers(1, &mPatchEBO);
+	if (mPatchVBO) glDeleteBuffers(1, &mPatchVBO);
+	if (mPatchVAO) glDeleteVertexArrays(1, &mPatchVAO);
+}
+
+bool TerrainRenderer::Setup(const std::vector<Vertex>& gridVertices, int resolution)
+{
+	BuildQuadtree(gridVertices, resolution);
+	if (mNodes.empty()) return false;
+
+	UploadTextures(gridVertices);
+	if (!mPatchVAO) CreatePatch();
+
+	size_t textureBytes = static_cast<size_t>(mResolution) * mResolution * (sizeof(float) + 4);
+	std::cout << "Terrain heightmap: " << mResolution << "x" << mResolution << " texels (" << textureBytes / (1024.0 * 1024.0) << " MB), "
+		<< (PatchSize + 1) * (PatchSize + 1) << " patch vertices\n";
+	return true;
+}
+
+void TerrainRenderer::BuildQuadtree(const std::vector<Vertex>& gridVertices, int resolution)
+{
+	mNodes.clear();
+	mSelectedNodes.clear();
+	mStats = TerrainLodStats();
+	mResolution = resolution;
+	mLevelCount = 0;
+	if (resolution < 2 || gridVertices.size() < static_cast<size_t>(resolution) * resolution) return;
+
+	// Grid placement, vertex i * resolution + j sits at origin + (i, j) * spacing
+	int cells = resolution - 1;
+	const glm::vec3& lastVertex = gridVertices[static_cast<size_t>(resolution) * resolution - 1].mPosition;
+	mOrigin = glm::vec2(gridVertices[0].mPosition.x, gridVertices[0].mPosition.z);
+	mSpacing = (glm::vec2(lastVertex.x, lastVertex.z) - mOrigin) / static_cast<float>(cells);
+
+	// The root covers the whole grid, each level below halves the node size down to a single patch
+	mLevelCount = 1;
+	while ((PatchSize << (mLevelCount - 1)) < cells && mLevelCount < MaxLevels)
+	{
+		mLevelCount++;
+	}
+
+	// Level 0 is used up to four leaf node sizes from the camera, every coarser level doubles the range
+	float leafSize = PatchSize * std::max(std::abs(mSpacing.x), std::abs(mSpacing.y));
+	for (int level = 0; level < MaxLevels; ++level)
+	{
+		mLodRanges[level] = leafSize * 4.f * static_cast<float>(1 << level);
+	}
+
+	BuildNode(0, 0, mLevelCount - 1, gridVertices);
+	std::cout << "Terrain quadtree: " << mNodes.size() << " nodes over " << mLevelCount << " levels\n";
+}
+
+int TerrainRenderer::BuildNode(int firstX, int firstZ, int level, const std::vector<Vertex>& gridVertices)
+{
+	int nodeIndex = static_cast<int>(mNodes.size());
+	mNodes.emplace_back();
+
+	int size = PatchSize << level;
+	int cells = mResolution - 1;
+	glm::vec3 minBounds(std::numeric_limits<float>::max());
+	glm::vec3 maxBounds(std::numeric_limits<float>::lowest());
+
+	if (level == 0)
+	{
+		// Leaf bounds over its vertices, the far edge row and column included
+		int endX = std::min(firstX + size, cells);
+		int endZ = std::min(firstZ + size, cells);
+		for (int i = firstX; i <= endX; ++i)
+		{
+			for (int j = firstZ; j <= endZ; ++j)
+			{
+				const glm::vec3& position = gridVertices[static_cast<size_t>(i) * mResolution + j].mPosition;
+				minBounds = glm::min(minBounds, position);
+				maxBounds = glm::max(maxBounds, position);
+			}
+		}
+	}
+	else
+	{
+		// Children outside the grid are left out, the bounds are the union of the children
+		int half = size / 2;
+		for (int childX = 0; childX < 2; ++childX)
+		{
+			for (int childZ = 0; childZ < 2; ++childZ)
+			{
+				int childFirstX = firstX + childX * half;
+				int childFirstZ = firstZ + childZ * half;
+				if (childFirstX >= cells || childFirstZ >= cells) continue;
+
+				int childIndex = BuildNode(childFirstX, childFirstZ, level - 1, gridVertices);
+				mNodes[nodeIndex].children[childX * 2 + childZ] = childIndex;
+				minBounds = glm::min(minBounds, mNodes[childIndex].minBounds);
+				maxBounds = glm::max(maxBounds, mNodes[childIndex].maxBounds);
+			}
+		}
+	}
+
+	QuadtreeNode& node = mNodes[nodeIndex];
+	node.firstX = firstX;
+	node.firstZ = firstZ;
+	node.size = size;
+	node.level = level;
+	node.minBounds = minBounds;
+	node.maxBounds = maxBounds;
+	return nodeIndex;
+}
+
+void TerrainRenderer::UploadTextures(const std::vector<Vertex>& gridVertices)
+{
+	// Texel (i, j) holds grid vertex i * resolution + j, so x runs along the texture width
+	size_t texelCount = static_cast<size_t>(mResolution) * mResolution;
+	std::vector<float> heights(texelCount);
+	std::vector<unsigned char> colors(texelCount * 4);
+	for (int i = 0; i < mResolution; ++i)
+	{
+		for (int j = 0; j < mResolution; ++j)
+		{
+			const Vertex& vertex = gridVertices[static_cast<size_t>(i) * mResolution + j];
+			size_t texel = static_cast<size_t>(j) * mResolution + i;
+			heights[texel] = vertex.mPosition.y;
+			for (int channel = 0; channel < 3; ++channel)
+			{
+				colors[texel * 4 + channel] = static_cast<unsigned char>(std::clamp(vertex.mColor[channel], 0.f, 1.f) * 255.f + 0.5f);
+			}
+			colors[texel * 4 + 3] = 255;
+		}
+	}
+
+	if (!mHeightTexture) glGenTextures(1, &mHeightTexture);
+	glBindTexture(GL_TEXTURE_2D, mHeightTexture);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, mResolution, mResolution, 0, GL_RED, GL_FLOAT, heights.data());
+
+	if (!mColorTexture) glGenTextures(1, &mColorTexture);
+	glBindTexture(GL_TEXTURE_2D, mColorTexture);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, mResolution, mResolution, 0, GL_RGBA, GL_UNSIGNED_BYTE, colors.data());
+	glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void TerrainRenderer::CreatePatch()
+{
+	// Unit patch in x and z, Shader.vs places, scales and displaces it per node
+	std::vector<Vertex> patchVertices;
+	patchVertices.reserve((PatchSize + 1) * (PatchSize + 1));
+	for (int i = 0; i <= PatchSize; ++i)
+	{
+		for (int j = 0; j <= PatchSize; ++j)
+		{
+			patchVertices.emplace_back(i / static_cast<float>(PatchSize), 0.f, j / static_cast<float>(PatchSize), 1.f, 1.f, 1.f);
+		}
+	}
+
+	// Same triangle layout as Mesh::TriangulateGrid
+	std::vector<Index> patchIndices;
+	patchIndices.reserve(PatchSize * PatchSize * 6);
+	for (int i = 0; i < PatchSize; ++i)
+	{
+		for (int j = 0; j < PatchSize; ++j)
+		{
+			Index index0 = i * (PatchSize + 1) + j;
+			Index index1 = (i + 1) * (PatchSize + 1) + j;
+			Index index2 = i * (PatchSize + 1) + (j + 1);
+			Index index3 = (i + 1) * (PatchSize + 1) + (j + 1);
+			patchIndices.insert(patchIndices.end(), { index0, index1, index2, index1, index3, index2 });
+		}
+	}
+	mPatchIndexCount = patchIndices.size();
+
+	glGenVertexArrays(1, &mPatchVAO);
+	glBindVertexArray(mPatchVAO);
+
+	glGenBuffers(1, &mPatchVBO);
+	glBindBuffer(GL_ARRAY_BUFFER, mPatchVBO);
+	glBufferData(GL_ARRAY_BUFFER, patchVertices.size() * sizeof(Vertex), patchVertices.data(), GL_STATIC_DRAW);
+
+	glGenBuffers(1, &mPatchEBO);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mPatchEBO);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, patchIndices.size() * sizeof(Index), patchIndices.data(), GL_STATIC_DRAW);
+
+	Vertex::SetupAttributes();
+	glBindVertexArray(0);
+}
+
+void TerrainRenderer::SelectNodes(const glm::mat4& modelViewProjection, const glm::vec3& cameraPosition)
+{
+	mSelectedNodes.clear();
+	mStats = TerrainLodStats();
+	mCameraPosition = cameraPosition;
+	if (mNodes.empty()) return;
+
+	mStats.finestLevel = mLevelCount - 1;
+	SelectNode(0, Frustum(modelViewProjection));
+}
+
+void TerrainRenderer::SelectNode(int nodeIndex, const Frustum& frustum)
+{
+	const QuadtreeNode& node = mNodes[nodeIndex];
+	if (!frustum.IntersectsBox(node.minBounds, node.maxBounds))
+	{
+		mStats.nodesCulled++;
+		return;
+	}
+
+	// Splitting while the camera is inside the range of the next finer level
+	glm::vec3 closestPoint = glm::clamp(mCameraPosition, node.minBounds, node.maxBounds);
+	if (node.level > 0 && glm::distance(closestPoint, mCameraPosition) < mLodRanges[node.level - 1])
+	{
+		for (int child : node.children)
+		{
+			if (child >= 0) SelectNode(child, frustum);
+		}
+		return;
+	}
+
+	mSelectedNodes.push_back(nodeIndex);
+	mStats.nodesSelected++;
+	mStats.trianglesDrawn += PatchSize * PatchSize * 2;
+	mStats.finestLevel = std::min(mStats.finestLevel, node.level);
+}
+
+void TerrainRenderer::Render(const Shader& shader) const
+{
+	if (mSelectedNodes.empty()) return;
+
+	glActiveTexture(GL_TEXTURE1);
+	glBindTexture(GL_TEXTURE_2D, mHeightTexture);
+	glActiveTexture(GL_TEXTURE2);
+	glBindTexture(GL_TEXTURE_2D, mColorTexture);
+	glActiveTexture(GL_TEXTURE0);
+
+	shader.setBool("useHeightmap", true);
+	shader.setInt("heightMap", 1);
+	shader.setInt("colorMap", 2);
+	shader.setVec2("terrainOrigin", mOrigin);
+	shader.setVec2("terrainSpacing", mSpacing);
+	shader.setFloat("terrainResolution", static_cast<float>(mResolution));
+	shader.setFloat("patchSize", static_cast<float>(PatchSize));
+	shader.setVec3("terrainCameraPos", mCameraPosition);
+
+	glBindVertexArray(mPatchVAO);
+	for (int nodeIndex : mSelectedNodes)
+	{
+		const QuadtreeNode& node = mNodes[nodeIndex];
+
+		// Vertices morph to the next coarser level over the last third of this level's range
+		float rangeStart = node.level > 0 ? mLodRanges[node.level - 1] : 0.f;
+		float rangeEnd = mLodRanges[node.level];
+		shader.setVec3("patchOffsetSize", static_cast<float>(node.firstX), static_cast<float>(node.firstZ), static_cast<float>(node.size));
+		shader.setVec2("morphRange", rangeStart + (rangeEnd - rangeStart) * 0.66f, rangeEnd);
+		glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(mPatchIndexCount), GL_UNSIGNED_INT, 0);
+	}
+	shader.setBool("useHeightmap", false);
+}
@@ -0,0 +1,93 @@
+#pragma once
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "utility/VariableTypes.h"
+
+class Frustum;
+class Shader;
+class Vertex;
+
+// Counters from the last SelectNodes() call
+struct TerrainLodStats
+{
+	size_t nodesSelected{ 0 };
+	size_t nodesCulled{ 0 };
+	size_t trianglesDrawn{ 0 };
+	int finestLevel{ 0 };
+};
+
+/*
+ * CDLOD terrain rendering, the gridded heights and colors live in textures and one shared grid patch is drawn per selected quadtree node
+ * Nodes near the camera are split into finer levels, and vertices morph towards the next coarser level near the end of their level's range,
+ * so neighbouring levels meet without cracks. Shader.vs displaces the patch when useHeightmap is set and takes the normals from the height texture
+ */
+class TerrainRenderer
+{
+public:
+	static constexpr int PatchSize = 32; // Quads per patch side, a level 0 patch has one quad per grid cell
+	static constexpr int MaxLevels = 12;
+
+	/*
+	 * Constructor and destructor
+	 */
+	TerrainRenderer() = default;
+	~TerrainRenderer();
+	TerrainRenderer(const TerrainRenderer&) = delete;
+	TerrainRenderer& operator=(const TerrainRenderer&) = delete;
+
+	/*
+	 * Setup, the grid vertices are laid out like Mesh::TriangulateGrid expects (index i * resolution + j)
+	 */
+	bool Setup(const std::vector<Vertex>& gridVertices, int resolution);
+	void BuildQuadtree(const std::vector<Vertex>& gridVertices, int resolution);
+	void UploadTextures(const std::vector<Vertex>& gridVertices);
+
+	/*
+	 * Selection and rendering, selection has no GL calls
+	 */
+	void SelectNodes(const glm::mat4& modelViewProjection, const glm::vec3& cameraPosition);
+	void Render(const Shader& shader) const;
+
+	/*
+	 * Getters
+	 */
+	const TerrainLodStats& GetStats() const { return mStats; }
+	int GetLevelCount() const { return mLevelCount; }
+	float GetLodRange(int level) const { return mLodRanges[level]; }
+
+private:
+	struct QuadtreeNode
+	{
+		int firstX{ 0 };
+		int firstZ{ 0 };
+		int size{ 0 }; // Grid cells per side
+		int level{ 0 };
+		glm::vec3 minBounds{ 0.f };
+		glm::vec3 maxBounds{ 0.f };
+		int children[4]{ -1, -1, -1, -1 };
+	};
+
+	int BuildNode(int firstX, int firstZ, int level, const std::vector<Vertex>& gridVertices);
+	void SelectNode(int nodeIndex, const Frustum& frustum);
+	void CreatePatch();
+
+	/*
+	 * Private Member Variables
+	 */
+	std::vector<QuadtreeNode> mNodes;
+	std::vector<int> mSelectedNodes;
+	float mLodRanges[MaxLevels]{};
+	TerrainLodStats mStats;
+	glm::vec3 mCameraPosition{ 0.f };
+	int mResolution{ 0 };
+	int mLevelCount{ 0 };
+	glm::vec2 mOrigin{ 0.f };
+	glm::vec2 mSpacing{ 1.f };
+	TextureID mHeightTexture{ 0 };
+	TextureID mColorTexture{ 0 };
+	VAO mPatchVAO{ 0 };
+	VBO mPatchVBO{ 0 };
+	EBO mPatchEBO{ 0 };
+	size_t mPatchIndexCount{ 0 };
+};
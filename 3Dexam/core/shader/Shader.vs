@@ -13,11 +13,53 @@ uniform mat4 projection;
 uniform mat4 view;  
 uniform mat4 model;  
 
+// Heightmap terrain (TerrainRenderer), aPos.xz is a point on the unit patch
+uniform bool useHeightmap;
+uniform sampler2D heightMap;
+uniform sampler2D colorMap;
+uniform vec2 terrainOrigin;
+uniform vec2 terrainSpacing;
+uniform float terrainResolution;
+uniform float patchSize;
+uniform vec3 patchOffsetSize; // First grid cell x, first grid cell z, grid cells covered by the patch
+uniform vec2 morphRange;
+uniform vec3 terrainCameraPos;
+
+float SampleHeight(vec2 gridPos)
+{  
+    return textureLod(heightMap, (gridPos + 0.5) / terrainResolution, 0.0).r;
+}  
+
 void main()  
 {  
-    gl_Position = projection * view * model * vec4(aPos, 1.0);  
-    FragPos = vec3(model * vec4(aPos, 1.0));  
-    Normal = mat3(transpose(inverse(model))) * aNormal;  
-    ourColor = aColor; // Pass the vertex color  
+    vec3 position = aPos;
+    vec3 normal = aNormal;
+    vec3 color = aColor;
+
+    if (useHeightmap)
+    {
+        vec2 gridPos = patchOffsetSize.xy + aPos.xz * patchOffsetSize.z;
+        vec2 worldXZ = terrainOrigin + gridPos * terrainSpacing;
+
+        // Odd patch vertices slide onto the next coarser grid as the camera distance nears the end of the level's range
+        float cameraDistance = distance(terrainCameraPos, vec3(worldXZ.x, SampleHeight(gridPos), worldXZ.y));
+        float morph = clamp((cameraDistance - morphRange.x) / (morphRange.y - morphRange.x), 0.0, 1.0);
+        gridPos -= fract(aPos.xz * patchSize * 0.5) * 2.0 / patchSize * patchOffsetSize.z * morph;
+        gridPos = min(gridPos, vec2(terrainResolution - 1.0));
+
+        worldXZ = terrainOrigin + gridPos * terrainSpacing;
+        position = vec3(worldXZ.x, SampleHeight(gridPos), worldXZ.y);
+
+        // Normal from the neighbouring heights, same orientation as Mesh::CalculateNormals
+        float heightX = SampleHeight(gridPos + vec2(1.0, 0.0)) - SampleHeight(gridPos - vec2(1.0, 0.0));
+        float heightZ = SampleHeight(gridPos + vec2(0.0, 1.0)) - SampleHeight(gridPos - vec2(0.0, 1.0));
+        normal = normalize(cross(vec3(2.0 * terrainSpacing.x, heightX, 0.0), vec3(0.0, heightZ, 2.0 * terrainSpacing.y)));
+        color = textureLod(colorMap, (gridPos + 0.5) / terrainResolution, 0.0).rgb;
+    }
+
+    gl_Position = projection * view * model * vec4(position, 1.0);
+    FragPos = vec3(model * vec4(position, 1.0));
+    Normal = mat3(transpose(inverse(model))) * normal;
+    ourColor = color; // Pass the vertex color
     UV = aUV;  
 }  
\ No newline at end of file
@@ -0,0 +1,63 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <queue>
+
+/*
+ * Blocking queue with a fixed capacity, used to connect pipeline stages running on separate threads
+ * Push() waits while the queue is full, Pop() waits until there is an item or the queue has been closed
+ */
+template <typename Type>
+class BoundedQueue
+{
+public:
+	explicit BoundedQueue(size_t capacity) : mCapacity(capacity > 0 ? capacity : 1) {}
+
+	bool Push(Type item)
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+		mNotFull.wait(lock, [this]() { return mIsClosed || mItems.size() < mCapacity; });
+		if (mIsClosed) return false;
+
+		mItems.push(std::move(item));
+		lock.unlock();
+		mNotEmpty.notify_one();
+		return true;
+	}
+
+	bool Pop(Type& item)
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+		mNotEmpty.wait(lock, [this]() { return mIsClosed || !mItems.empty(); });
+		if (mItems.empty()) return false;
+
+		item = std::move(mItems.front());
+		mItems.pop();
+		lock.unlock();
+		mNotFull.notify_one();
+		return true;
+	}
+
+	// Items already in the queue can still be popped after Close()
+	void Close()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mIsClosed = true;
+		}
+		mNotEmpty.notify_all();
+		mNotFull.notify_all();
+	}
+
+private:
+	/*
+	 * Private Member Variables
+	 */
+	std::queue<Type> mItems;
+	size_t mCapacity;
+	std::mutex mMutex;
+	std::condition_variable mNotEmpty;
+	std::condition_variable mNotFull;
+	bool mIsClosed{ false };
+};
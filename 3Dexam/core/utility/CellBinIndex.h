@@ -0,0 +1,102 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "PointKernels.h"
+
+/*
+ * Points binned into a regular grid of cells as a compressed sparse row index
+ * Points are counted per cell, the counts are prefix summed and the point indices are scattered into one flat array,
+ * so all points of a cell, and of a run of neighbouring cells along z, are contiguous in memory
+ * The x and z coordinates are stored in the same binned order, so range tests never have to touch the source points
+ */
+class CellBinIndex
+{
+public:
+	/*
+	 * Building, cells are counted from the origin and points outside the grid go into the nearest edge cell
+	 */
+	template <typename GetPosition>
+	void Build(size_t pointCount, GetPosition getPosition, float originX, float originZ, float cellSize, int cellsX, int cellsZ)
+	{
+		// Gathering x and z into separate arrays first, the cell index kernel and the scatter pass both read them
+		std::vector<float> pointX(pointCount);
+		std::vector<float> pointZ(pointCount);
+		for (size_t i = 0; i < pointCount; ++i)
+		{
+			auto position = getPosition(i);
+			pointX[i] = position.x;
+			pointZ[i] = position.z;
+		}
+		Build(pointX.data(), pointZ.data(), pointCount, originX, originZ, cellSize, cellsX, cellsZ);
+	}
+
+	void Build(const float* pointX, const float* pointZ, size_t pointCount, float originX, float originZ, float cellSize, int cellsX, int cellsZ)
+	{
+		mOriginX = originX;
+		mOriginZ = originZ;
+		mInverseCellSize = 1.f / cellSize;
+		mCellsX = std::max(cellsX, 1);
+		mCellsZ = std::max(cellsZ, 1);
+
+		// Counting the points per cell, the cell of every point is kept for the scatter pass
+		std::vector<uint32_t> pointCells(pointCount);
+		PointKernels::ComputeCellIndices(pointX, pointZ, pointCount, mOriginX, mOriginZ, mInverseCellSize, mCellsX, mCellsZ, pointCells.data());
+		mCellStarts.assign(static_cast<size_t>(mCellsX) * mCellsZ + 1, 0);
+		for (size_t i = 0; i < pointCount; ++i)
+		{
+			mCellStarts[pointCells[i] + 1]++;
+		}
+
+		// Prefix sum, mCellStarts[cell] is where the points of a cell begin
+		for (size_t cell = 1; cell < mCellStarts.size(); ++cell)
+		{
+			mCellStarts[cell] += mCellStarts[cell - 1];
+		}
+
+		// Scattering, points keep their input order inside a cell
+		std::vector<size_t> cellCursors(mCellStarts.begin(), mCellStarts.end() - 1);
+		mBinnedPoints.resize(pointCount);
+		mBinnedX.resize(pointCount);
+		mBinnedZ.resize(pointCount);
+		for (size_t i = 0; i < pointCount; ++i)
+		{
+			size_t binned = cellCursors[pointCells[i]]++;
+			mBinnedPoints[binned] = static_cast<uint32_t>(i);
+			mBinnedX[binned] = pointX[i];
+			mBinnedZ[binned] = pointZ[i];
+		}
+	}
+
+	/*
+	 * Lookups
+	 */
+	int GetCellX(float x) const { return PointKernels::GetCellCoordinate(x, mOriginX, mInverseCellSize, mCellsX); }
+	int GetCellZ(float z) const { return PointKernels::GetCellCoordinate(z, mOriginZ, mInverseCellSize, mCellsZ); }
+
+	// Binned range of the cells (cellX, firstCellZ) to (cellX, lastCellZ)
+	size_t GetRangeBegin(int cellX, int firstCellZ) const { return mCellStarts[static_cast<size_t>(cellX) * mCellsZ + firstCellZ]; }
+	size_t GetRangeEnd(int cellX, int lastCellZ) const { return mCellStarts[static_cast<size_t>(cellX) * mCellsZ + lastCellZ + 1]; }
+
+	/*
+	 * Getters
+	 */
+	const std::vector<uint32_t>& GetBinnedPoints() const { return mBinnedPoints; }
+	const std::vector<float>& GetBinnedX() const { return mBinnedX; }
+	const std::vector<float>& GetBinnedZ() const { return mBinnedZ; }
+
+private:
+	/*
+	 * Private Member Variables
+	 */
+	std::vector<size_t> mCellStarts;
+	std::vector<uint32_t> mBinnedPoints;
+	std::vector<float> mBinnedX;
+	std::vector<float> mBinnedZ;
+	float mOriginX{ 0.f };
+	float mOriginZ{ 0.f };
+	float mInverseCellSize{ 1.f };
+	int mCellsX{ 1 };
+	int mCellsZ{ 1 };
+};
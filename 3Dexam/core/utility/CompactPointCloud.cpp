@@ -0,0 +1,126 @@
+#include "CompactPointCloud.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <limits>
+
+#include "graphical/Mesh.h"
+#include "ReadWriteFiles.h"
+
+namespace
+{
+	constexpr double QuantisedRange = 2147483647.0;
+
+	int32_t Quantise(double value)
+	{
+		return static_cast<int32_t>(std::llround(std::clamp(value, -QuantisedRange, QuantisedRange)));
+	}
+
+	uint8_t QuantiseColor(float value)
+	{
+		return static_cast<uint8_t>(std::lround(std::clamp(value, 0.f, 1.f) * 255.f));
+	}
+}
+
+void CompactPointCloud::SetBounds(const glm::vec3& boundsMin, const glm::vec3& boundsMax)
+{
+	mPoints.clear();
+	mBoundsMin = boundsMin;
+	mBoundsMax = boundsMax;
+
+	// Quantising around the center uses the whole signed int32 range on each axis
+	mOffset = (glm::dvec3(boundsMin) + glm::dvec3(boundsMax)) * 0.5;
+	glm::dvec3 halfExtent = (glm::dvec3(boundsMax) - glm::dvec3(boundsMin)) * 0.5;
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		mScale[axis] = halfExtent[axis] > 0.0 ? halfExtent[axis] / QuantisedRange : 1.0;
+	}
+}
+
+void CompactPointCloud::AddPoint(const glm::vec3& position, const glm::vec3& color)
+{
+	glm::dvec3 quantised = (glm::dvec3(position) - mOffset) / mScale;
+
+	CompactPoint point;
+	point.x = Quantise(quantised.x);
+	point.y = Quantise(quantised.y);
+	point.z = Quantise(quantised.z);
+	point.r = QuantiseColor(color.r);
+	point.g = QuantiseColor(color.g);
+	point.b = QuantiseColor(color.b);
+	mPoints.push_back(point);
+}
+
+void CompactPointCloud::Translate(const glm::vec3& offset)
+{
+	// Only the dequantisation offset moves, the stored points stay the same
+	mOffset += glm::dvec3(offset);
+	mBoundsMin += offset;
+	mBoundsMax += offset;
+}
+
+Vertex CompactPointCloud::GetVertex(size_t index) const
+{
+	glm::vec3 position = GetPosition(index);
+	glm::vec3 color = GetColor(index);
+	return Vertex(position.x, position.y, position.z, color.r, color.g, color.b);
+}
+
+bool CompactPointCloud::LoadFromFile(const std::string& filePath, bool usingColors, CompactPointCloud& pointCloud)
+{
+	auto startTime = std::chrono::high_resolution_clock::now();
+
+	// First pass, the bounds are needed before any point can be quantised
+	glm::vec3 boundsMin(std::numeric_limits<float>::max());
+	glm::vec3 boundsMax(std::numeric_limits<float>::lowest());
+	size_t pointCount = 0;
+	bool bIsRead = ReadWriteFiles::ForEachPointInFile(filePath, usingColors, [&](const Vertex& vertex)
+		{
+			boundsMin = glm::min(boundsMin, vertex.mPosition);
+			boundsMax = glm::max(boundsMax, vertex.mPosition);
+			pointCount++;
+		});
+	if (!bIsRead || pointCount == 0)
+	{
+		std::cerr << "No points found in: " << filePath << std::endl;
+		return false;
+	}
+
+	// Second pass, quantising every point
+	pointCloud.SetBounds(boundsMin, boundsMax);
+	pointCloud.Reserve(pointCount);
+	ReadWriteFiles::ForEachPointInFile(filePath, usingColors, [&](const Vertex& vertex)
+		{
+			pointCloud.AddPoint(vertex.mPosition, vertex.mColor);
+		});
+
+	std::chrono::duration<double> elapsedTime = std::chrono::high_resolution_clock::now() - startTime;
+	std::cout << "Compact point cloud: " << pointCount << " points, " << pointCount * sizeof(CompactPoint) / (1024.0 * 1024.0) << " MB ("
+		<< pointCount * sizeof(Vertex) / (1024.0 * 1024.0) << " MB as vertices), loaded in " << elapsedTime.count() << " s\n";
+	return true;
+}
+
+void CompactPointCloud::FromVertices(const std::vector<Vertex>& vertices, CompactPointCloud& pointCloud)
+{
+	if (vertices.empty())
+	{
+		pointCloud.SetBounds(glm::vec3(0.f), glm::vec3(0.f));
+		return;
+	}
+
+	glm::vec3 boundsMin = vertices[0].mPosition;
+	glm::vec3 boundsMax = vertices[0].mPosition;
+	for (const auto& vertex : vertices)
+	{
+		boundsMin = glm::min(boundsMin, vertex.mPosition);
+		boundsMax = glm::max(boundsMax, vertex.mPosition);
+	}
+
+	pointCloud.SetBounds(boundsMin, boundsMax);
+	pointCloud.Reserve(vertices.size());
+	for (const auto& vertex : vertices)
+	{
+		pointCloud.AddPoint(vertex.mPosition, vertex.mColor);
+	}
+}
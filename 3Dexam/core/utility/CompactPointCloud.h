@@ -0,0 +1,75 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+
+class Vertex;
+
+/*
+ * One point of a CompactPointCloud, 16 bytes instead of the 56 bytes of a Vertex
+ * Positions are int32 values quantised against the cloud bounds, colors are RGB8
+ */
+struct CompactPoint
+{
+	int32_t x{ 0 };
+	int32_t y{ 0 };
+	int32_t z{ 0 };
+	uint8_t r{ 0 };
+	uint8_t g{ 0 };
+	uint8_t b{ 0 };
+	uint8_t padding{ 0 };
+};
+
+/*
+ * Point storage for the ingestion path, only keeps what the terrain gridding reads (position and color)
+ * SetBounds() has to be called before points are added, every point is expected to lie inside those bounds
+ */
+class CompactPointCloud
+{
+public:
+	/*
+	 * Building
+	 */
+	void SetBounds(const glm::vec3& boundsMin, const glm::vec3& boundsMax);
+	void Reserve(size_t pointCount) { mPoints.reserve(pointCount); }
+	void AddPoint(const glm::vec3& position, const glm::vec3& color);
+	void Translate(const glm::vec3& offset);
+
+	static bool LoadFromFile(const std::string& filePath, bool usingColors, CompactPointCloud& pointCloud);
+	static void FromVertices(const std::vector<Vertex>& vertices, CompactPointCloud& pointCloud);
+
+	/*
+	 * Getters, positions and colors are dequantised on access
+	 */
+	size_t GetPointCount() const { return mPoints.size(); }
+	bool IsEmpty() const { return mPoints.empty(); }
+	const std::vector<CompactPoint>& GetPoints() const { return mPoints; }
+	glm::vec3 GetBoundsMin() const { return mBoundsMin; }
+	glm::vec3 GetBoundsMax() const { return mBoundsMax; }
+	glm::vec3 GetPrecision() const { return glm::vec3(mScale * 0.5); }
+
+	glm::vec3 GetPosition(size_t index) const
+	{
+		const CompactPoint& point = mPoints[index];
+		return glm::vec3(mOffset + glm::dvec3(point.x, point.y, point.z) * mScale);
+	}
+
+	glm::vec3 GetColor(size_t index) const
+	{
+		const CompactPoint& point = mPoints[index];
+		return glm::vec3(point.r, point.g, point.b) * (1.f / 255.f);
+	}
+
+	Vertex GetVertex(size_t index) const;
+
+private:
+	/*
+	 * Private Member Variables
+	 */
+	std::vector<CompactPoint> mPoints;
+	glm::vec3 mBoundsMin{ 0.f };
+	glm::vec3 mBoundsMax{ 0.f };
+	glm::dvec3 mOffset{ 0.0 }; // Position of the quantised value 0, the center of the bounds
+	glm::dvec3 mScale{ 1.0 }; // Size of one quantisation step per axis
+};
@@ -152,10 +152,25 @@ void Controller::GeneralInputs(double dt)
 		scenePtr->shouldSimualtePhysics = false;
 	}
 
-	if (glfwGetKey(mWindow, GLFW_KEY_G) == GLFW_PRESS)
+	// One object per key press, at the terrain point under the cursor, or under the screen centre while the cursor is captured
+	bool spawnKeyDown = glfwGetKey(mWindow, GLFW_KEY_G) == GLFW_PRESS;
+	if (spawnKeyDown && !mSpawnKeyHeld)
 	{
-		scenePtr->SpawnObjects();
+		glm::vec2 cursorPosition{ 0.f };
+		if (glfwGetInputMode(mWindow, GLFW_CURSOR) != GLFW_CURSOR_DISABLED)
+		{
+			double cursorX, cursorY;
+			int windowWidth, windowHeight;
+			glfwGetCursorPos(mWindow, &cursorX, &cursorY);
+			glfwGetWindowSize(mWindow, &windowWidth, &windowHeight);
+			if (windowWidth > 0 && windowHeight > 0)
+			{
+				cursorPosition = glm::vec2(2.f * static_cast<float>(cursorX) / windowWidth - 1.f, 1.f - 2.f * static_cast<float>(cursorY) / windowHeight);
+			}
+		}
+		scenePtr->SpawnObjects(cursorPosition);
 	}
+	mSpawnKeyHeld = spawnKeyDown;
 
 	if (glfwGetKey(mWindow, GLFW_KEY_U) == GLFW_PRESS)
 	{
@@ -41,6 +41,7 @@ public:
 	float mPlayerSpeed{ 8.f };
 	ControllerType controllerState{ CAMERA };
 	bool bUsePlayerController = false;
+	bool mSpawnKeyHeld{ false };
 	// Misc variables
 	float mScreenWidth;
 	float mScreenHeight;
@@ -0,0 +1,46 @@
+#pragma once
+#include <glm/glm.hpp>
+
+/*
+ * View frustum as six planes taken from a (model-)view-projection matrix (Gribb/Hartmann)
+ * Plane normals point inwards, so a point is inside when it is on the positive side of all six
+ */
+class Frustum
+{
+public:
+	explicit Frustum(const glm::mat4& viewProjection)
+	{
+		// glm is column major, row r of the matrix is (m[0][r], m[1][r], m[2][r], m[3][r])
+		glm::vec4 rowX(viewProjection[0][0], viewProjection[1][0], viewProjection[2][0], viewProjection[3][0]);
+		glm::vec4 rowY(viewProjection[0][1], viewProjection[1][1], viewProjection[2][1], viewProjection[3][1]);
+		glm::vec4 rowZ(viewProjection[0][2], viewProjection[1][2], viewProjection[2][2], viewProjection[3][2]);
+		glm::vec4 rowW(viewProjection[0][3], viewProjection[1][3], viewProjection[2][3], viewProjection[3][3]);
+
+		mPlanes[0] = rowW + rowX; // Left
+		mPlanes[1] = rowW - rowX; // Right
+		mPlanes[2] = rowW + rowY; // Bottom
+		mPlanes[3] = rowW - rowY; // Top
+		mPlanes[4] = rowW + rowZ; // Near
+		mPlanes[5] = rowW - rowZ; // Far
+	}
+
+	// Conservative box test, only boxes fully outside one plane are rejected
+	bool IntersectsBox(const glm::vec3& minBounds, const glm::vec3& maxBounds) const
+	{
+		for (const auto& plane : mPlanes)
+		{
+			// The box corner furthest along the plane normal
+			glm::vec3 corner(plane.x >= 0.f ? maxBounds.x : minBounds.x,
+				plane.y >= 0.f ? maxBounds.y : minBounds.y,
+				plane.z >= 0.f ? maxBounds.z : minBounds.z);
+			if (glm::dot(glm::vec3(plane), corner) + plane.w < 0.f) return false;
+		}
+		return true;
+	}
+
+private:
+	/*
+	 * Private Member Variables
+	 */
+	glm::vec4 mPlanes[6];
+};
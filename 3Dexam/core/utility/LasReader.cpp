@@ -0,0 +1,144 @@
+#include "LasReader.h"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <iostream>
+
+namespace
+{
+	// LAS files are little endian, like every platform this project builds for
+	template <typename Type>
+	Type ReadValue(const char* data, size_t offset)
+	{
+		Type value;
+		std::memcpy(&value, data + offset, sizeof(Type));
+		return value;
+	}
+
+	struct LasPointFormatLayout
+	{
+		uint16_t recordLength;
+		int colorOffset;
+	};
+
+	// Minimum record length and RGB offset for point formats 0 - 10, records can be longer when they carry extra bytes
+	constexpr LasPointFormatLayout PointFormatLayouts[] =
+	{
+		{ 20, -1 }, { 28, -1 }, { 26, 20 }, { 34, 28 }, { 57, -1 }, { 63, 28 },
+		{ 30, -1 }, { 36, 30 }, { 38, 30 }, { 59, -1 }, { 67, 30 }
+	};
+
+	constexpr size_t MinimumHeaderSize = 227;
+}
+
+bool LasReader::IsLasFile(const std::string& filePath)
+{
+	if (filePath.size() < 4) return false;
+	std::string extension = filePath.substr(filePath.size() - 4);
+	std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+	return extension == ".las";
+}
+
+bool LasReader::Open(const std::string& filePath)
+{
+	mHeader = LasHeader();
+	mColorOffset = -1;
+	if (!mFile.Open(filePath) || mFile.GetSize() < MinimumHeaderSize || std::memcmp(mFile.GetData(), "LASF", 4) != 0)
+	{
+		std::cerr << "Not a LAS file: " << filePath << std::endl;
+		return false;
+	}
+
+	const char* data = mFile.GetData();
+	mHeader.versionMajor = ReadValue<uint8_t>(data, 24);
+	mHeader.versionMinor = ReadValue<uint8_t>(data, 25);
+	mHeader.headerSize = ReadValue<uint16_t>(data, 94);
+	mHeader.pointDataOffset = ReadValue<uint32_t>(data, 96);
+	mHeader.pointFormat = ReadValue<uint8_t>(data, 104);
+	mHeader.pointRecordLength = ReadValue<uint16_t>(data, 105);
+	mHeader.pointCount = ReadValue<uint32_t>(data, 107);
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		mHeader.scale[axis] = ReadValue<double>(data, 131 + axis * 8);
+		mHeader.offset[axis] = ReadValue<double>(data, 155 + axis * 8);
+		mHeader.boundsMax[axis] = ReadValue<double>(data, 179 + axis * 16);
+		mHeader.boundsMin[axis] = ReadValue<double>(data, 187 + axis * 16);
+	}
+
+	// LAS 1.4 moved the point count to a 64 bit field, the legacy field is 0 for files with more than 4 billion points
+	if (mHeader.versionMinor >= 4 && mHeader.headerSize >= 255 && mFile.GetSize() >= 255)
+	{
+		uint64_t extendedPointCount = ReadValue<uint64_t>(data, 247);
+		if (extendedPointCount > 0) mHeader.pointCount = extendedPointCount;
+	}
+
+	if (mHeader.versionMajor != 1 || mHeader.versionMinor > 4 || mHeader.headerSize < MinimumHeaderSize)
+	{
+		std::cerr << "Unsupported LAS version " << int(mHeader.versionMajor) << "." << int(mHeader.versionMinor) << ": " << filePath << std::endl;
+		return false;
+	}
+
+	// The two high bits of the point format are set for LAZ compressed points
+	if ((mHeader.pointFormat & 0xC0) != 0 || mHeader.pointFormat >= std::size(PointFormatLayouts))
+	{
+		std::cerr << "Unsupported LAS point format " << int(mHeader.pointFormat) << " (compressed LAZ files are not supported): " << filePath << std::endl;
+		return false;
+	}
+
+	const LasPointFormatLayout& layout = PointFormatLayouts[mHeader.pointFormat];
+	if (mHeader.pointRecordLength < layout.recordLength ||
+		mHeader.pointDataOffset + mHeader.pointCount * mHeader.pointRecordLength > mFile.GetSize())
+	{
+		std::cerr << "LAS point records do not fit the file: " << filePath << std::endl;
+		return false;
+	}
+	mColorOffset = layout.colorOffset;
+
+	// RGB should be stored as 16 bit values, but a lot of exporters write 8 bit colors into them, so a sample of points decides the scale
+	if (HasColors())
+	{
+		const uint64_t sampleCount = std::min<uint64_t>(mHeader.pointCount, 4096);
+		uint16_t maxColor = 0;
+		for (uint64_t i = 0; i < sampleCount; ++i)
+		{
+			uint64_t point = i * mHeader.pointCount / sampleCount;
+			const char* record = data + mHeader.pointDataOffset + point * mHeader.pointRecordLength;
+			for (int channel = 0; channel < 3; ++channel)
+			{
+				maxColor = std::max(maxColor, ReadValue<uint16_t>(record, mColorOffset + channel * 2));
+			}
+		}
+		mColorScale = maxColor <= 255 ? 1.f / 255.f : 1.f / 65535.f;
+	}
+
+	std::cout << "LAS " << int(mHeader.versionMajor) << "." << int(mHeader.versionMinor) << " file, point format " << int(mHeader.pointFormat)
+		<< ", " << mHeader.pointCount << " points" << (HasColors() ? " with RGB" : "") << "\n";
+	return true;
+}
+
+void LasReader::DecodePoints(uint64_t firstPoint, uint64_t pointCount, float* positions, float* colors) const
+{
+	const char* record = mFile.GetData() + mHeader.pointDataOffset + firstPoint * mHeader.pointRecordLength;
+	for (uint64_t i = 0; i < pointCount; ++i, record += mHeader.pointRecordLength)
+	{
+		// LAS is z-up, so y and z are swapped to get vertex positions
+		float* position = positions + i * 3;
+		position[0] = static_cast<float>(ReadValue<int32_t>(record, 0) * mHeader.scale[0] + mHeader.offset[0]);
+		position[1] = static_cast<float>(ReadValue<int32_t>(record, 8) * mHeader.scale[2] + mHeader.offset[2]);
+		position[2] = static_cast<float>(ReadValue<int32_t>(record, 4) * mHeader.scale[1] + mHeader.offset[1]);
+
+		if (colors == nullptr) continue;
+		float* color = colors + i * 3;
+		if (HasColors())
+		{
+			for (int channel = 0; channel < 3; ++channel)
+			{
+				color[channel] = std::min(ReadValue<uint16_t>(record, mColorOffset + channel * 2) * mColorScale, 1.f);
+			}
+		}
+		else
+		{
+			color[0] = color[1] = color[2] = 1.f;
+		}
+	}
+}
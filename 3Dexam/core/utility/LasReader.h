@@ -0,0 +1,58 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+#include "MappedFile.h"
+
+/*
+ * The parts of a LAS 1.0 - 1.4 public header block needed to decode the point records
+ */
+struct LasHeader
+{
+	uint8_t versionMajor{ 0 };
+	uint8_t versionMinor{ 0 };
+	uint16_t headerSize{ 0 };
+	uint32_t pointDataOffset{ 0 };
+	uint8_t pointFormat{ 0 };
+	uint16_t pointRecordLength{ 0 };
+	uint64_t pointCount{ 0 };
+	double scale[3]{ 1.0, 1.0, 1.0 };
+	double offset[3]{ 0.0, 0.0, 0.0 };
+	double boundsMin[3]{ 0.0, 0.0, 0.0 };
+	double boundsMax[3]{ 0.0, 0.0, 0.0 };
+};
+
+/*
+ * Reads uncompressed LAS files straight from a memory mapping, point formats 0 - 10 are supported
+ * Records are decoded with the header scale and offset, and positions come out with y and z swapped like the text loader
+ */
+class LasReader
+{
+public:
+	static bool IsLasFile(const std::string& filePath);
+
+	bool Open(const std::string& filePath);
+
+	/*
+	 * Decodes the points [firstPoint, firstPoint + pointCount) into x, y, z floats, colors (r, g, b in 0 - 1) are optional
+	 * Point formats without RGB decode every color as white
+	 */
+	void DecodePoints(uint64_t firstPoint, uint64_t pointCount, float* positions, float* colors) const;
+
+	/*
+	 * Getters
+	 */
+	const LasHeader& GetHeader() const { return mHeader; }
+	uint64_t GetPointCount() const { return mHeader.pointCount; }
+	bool HasColors() const { return mColorOffset >= 0; }
+	size_t GetPointDataSize() const { return static_cast<size_t>(mHeader.pointCount * mHeader.pointRecordLength); }
+
+private:
+	/*
+	 * Private Member Variables
+	 */
+	MappedFile mFile;
+	LasHeader mHeader;
+	int mColorOffset{ -1 }; // Byte offset of the RGB values inside a record, -1 for formats without color
+	float mColorScale{ 1.f / 65535.f };
+};
@@ -0,0 +1,128 @@
+#include "MappedFile.h"
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile(const std::string& filePath)
+{
+	Open(filePath);
+}
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+{
+	*this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+	if (this != &other)
+	{
+		Close();
+		std::swap(mData, other.mData);
+		std::swap(mSize, other.mSize);
+		std::swap(mIsOpen, other.mIsOpen);
+#ifdef _WIN32
+		std::swap(mFileHandle, other.mFileHandle);
+		std::swap(mMappingHandle, other.mMappingHandle);
+#else
+		std::swap(mFileDescriptor, other.mFileDescriptor);
+#endif
+	}
+	return *this;
+}
+
+bool MappedFile::Open(const std::string& filePath)
+{
+	Close();
+
+#ifdef _WIN32
+	HANDLE file = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE) return false;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize))
+	{
+		CloseHandle(file);
+		return false;
+	}
+	mFileHandle = file;
+	mSize = static_cast<size_t>(fileSize.QuadPart);
+
+	// Windows refuses to map empty files, those are exposed as an open file without data
+	if (mSize > 0)
+	{
+		HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (mapping == nullptr)
+		{
+			Close();
+			return false;
+		}
+		mMappingHandle = mapping;
+
+		mData = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+		if (mData == nullptr)
+		{
+			Close();
+			return false;
+		}
+	}
+#else
+	mFileDescriptor = open(filePath.c_str(), O_RDONLY);
+	if (mFileDescriptor < 0) return false;
+
+	struct stat fileStat;
+	if (fstat(mFileDescriptor, &fileStat) != 0)
+	{
+		Close();
+		return false;
+	}
+	mSize = static_cast<size_t>(fileStat.st_size);
+
+	if (mSize > 0)
+	{
+		void* mapping = mmap(nullptr, mSize, PROT_READ, MAP_PRIVATE, mFileDescriptor, 0);
+		if (mapping == MAP_FAILED)
+		{
+			Close();
+			return false;
+		}
+		madvise(mapping, mSize, MADV_SEQUENTIAL);
+		mData = static_cast<const char*>(mapping);
+	}
+#endif
+
+	mIsOpen = true;
+	return true;
+}
+
+void MappedFile::Close()
+{
+#ifdef _WIN32
+	if (mData != nullptr) UnmapViewOfFile(mData);
+	if (mMappingHandle != nullptr) CloseHandle(mMappingHandle);
+	if (mFileHandle != nullptr) CloseHandle(mFileHandle);
+	mMappingHandle = nullptr;
+	mFileHandle = nullptr;
+#else
+	if (mData != nullptr) munmap(const_cast<char*>(mData), mSize);
+	if (mFileDescriptor >= 0) close(mFileDescriptor);
+	mFileDescriptor = -1;
+#endif
+	mData = nullptr;
+	mSize = 0;
+	mIsOpen = false;
+}
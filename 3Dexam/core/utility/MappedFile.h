@@ -0,0 +1,46 @@
+#pragma once
+#include <cstddef>
+#include <string>
+
+/*
+ * Read-only memory mapping of a file, the whole file is exposed as one contiguous char range
+ */
+class MappedFile
+{
+public:
+	/*
+	 * Constructors and mapping
+	 */
+	MappedFile() = default;
+	explicit MappedFile(const std::string& filePath);
+	~MappedFile();
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+	MappedFile(MappedFile&& other) noexcept;
+	MappedFile& operator=(MappedFile&& other) noexcept;
+
+	bool Open(const std::string& filePath);
+	void Close();
+
+	/*
+	 * Getters
+	 */
+	bool IsOpen() const { return mIsOpen; }
+	const char* GetData() const { return mData; }
+	const char* GetEnd() const { return mData + mSize; }
+	size_t GetSize() const { return mSize; }
+
+private:
+	/*
+	 * Private Member Variables
+	 */
+	const char* mData{ nullptr };
+	size_t mSize{ 0 };
+	bool mIsOpen{ false };
+#ifdef _WIN32
+	void* mFileHandle{ nullptr };
+	void* mMappingHandle{ nullptr };
+#else
+	int mFileDescriptor{ -1 };
+#endif
+};
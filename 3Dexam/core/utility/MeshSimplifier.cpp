@@ -0,0 +1,327 @@
+#include "MeshSimplifier.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <queue>
+#include <glm/glm.hpp>
+
+#include "graphical/Mesh.h"
+
+namespace
+{
+	// Symmetric 4x4 error quadric, only the upper triangle is stored
+	struct Quadric
+	{
+		double a2{ 0.0 }, ab{ 0.0 }, ac{ 0.0 }, ad{ 0.0 };
+		double b2{ 0.0 }, bc{ 0.0 }, bd{ 0.0 };
+		double c2{ 0.0 }, cd{ 0.0 };
+		double d2{ 0.0 };
+
+		Quadric() = default;
+		Quadric(double a, double b, double c, double d)
+			: a2(a * a), ab(a * b), ac(a * c), ad(a * d), b2(b * b), bc(b * c), bd(b * d), c2(c * c), cd(c * d), d2(d * d) {}
+
+		Quadric& operator+=(const Quadric& other)
+		{
+			a2 += other.a2; ab += other.ab; ac += other.ac; ad += other.ad;
+			b2 += other.b2; bc += other.bc; bd += other.bd;
+			c2 += other.c2; cd += other.cd;
+			d2 += other.d2;
+			return *this;
+		}
+
+		double Evaluate(const glm::vec3& p) const
+		{
+			double x = p.x, y = p.y, z = p.z;
+			return a2 * x * x + 2.0 * ab * x * y + 2.0 * ac * x * z + 2.0 * ad * x
+				+ b2 * y * y + 2.0 * bc * y * z + 2.0 * bd * y
+				+ c2 * z * z + 2.0 * cd * z
+				+ d2;
+		}
+	};
+
+	// Candidate collapse of from onto to, ordered by cost and then by the quadric error
+	struct Collapse
+	{
+		double cost{ 0.0 };
+		double quadricCost{ 0.0 };
+		uint32_t from{ 0 };
+		uint32_t to{ 0 };
+		uint32_t fromVersion{ 0 };
+		uint32_t toVersion{ 0 };
+
+		bool operator>(const Collapse& other) const { return cost > other.cost || (cost == other.cost && quadricCost > other.quadricCost); }
+	};
+
+	// Twice the signed area of the triangle projected onto the xz plane
+	float SignedAreaXZ(const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2)
+	{
+		return (p1.x - p0.x) * (p2.z - p0.z) - (p2.x - p0.x) * (p1.z - p0.z);
+	}
+
+	// Calls visit(vertexIndex, surfaceHeight) for every grid vertex inside or on the edge of the triangle, the weights come from the integer grid coordinates
+	template <typename Visitor>
+	void RasterizeGridTriangle(const std::vector<Vertex>& gridVertices, int resolution, const Index corners[3], Visitor&& visit)
+	{
+		glm::ivec2 grid[3];
+		for (int corner = 0; corner < 3; ++corner)
+		{
+			grid[corner] = glm::ivec2(static_cast<int>(corners[corner] / resolution), static_cast<int>(corners[corner] % resolution));
+		}
+		int area = (grid[1].x - grid[0].x) * (grid[2].y - grid[0].y) - (grid[2].x - grid[0].x) * (grid[1].y - grid[0].y);
+		if (area == 0) return;
+
+		glm::ivec2 minGrid = glm::min(grid[0], glm::min(grid[1], grid[2]));
+		glm::ivec2 maxGrid = glm::max(grid[0], glm::max(grid[1], grid[2]));
+		for (int i = minGrid.x; i <= maxGrid.x; ++i)
+		{
+			for (int j = minGrid.y; j <= maxGrid.y; ++j)
+			{
+				// Edge functions, all three share the triangle's winding when the grid point is inside or on an edge
+				int w0 = (grid[2].x - grid[1].x) * (j - grid[1].y) - (i - grid[1].x) * (grid[2].y - grid[1].y);
+				int w1 = (grid[0].x - grid[2].x) * (j - grid[2].y) - (i - grid[2].x) * (grid[0].y - grid[2].y);
+				int w2 = area - w0 - w1;
+				if (area > 0 ? (w0 < 0 || w1 < 0 || w2 < 0) : (w0 > 0 || w1 > 0 || w2 > 0)) continue;
+
+				float surfaceHeight = (w0 * gridVertices[corners[0]].mPosition.y + w1 * gridVertices[corners[1]].mPosition.y + w2 * gridVertices[corners[2]].mPosition.y) / area;
+				visit(static_cast<size_t>(i) * resolution + j, surfaceHeight);
+			}
+		}
+	}
+}
+
+SimplifyStats MeshSimplifier::Simplify(const std::vector<Vertex>& vertices, int gridResolution, std::vector<Index>& indices, const std::vector<uint8_t>& lockedVertices, const SimplifySettings& settings)
+{
+	auto startTime = std::chrono::high_resolution_clock::now();
+	SimplifyStats stats;
+	const size_t triangleCount = indices.size() / 3;
+	stats.inputTriangles = triangleCount;
+	stats.outputTriangles = triangleCount;
+
+	const size_t targetTriangles = settings.targetTriangleCount;
+	const float maxHeightError = settings.maxHeightError > 0.f ? settings.maxHeightError : std::numeric_limits<float>::max();
+	if (triangleCount == 0 || (targetTriangles == 0 && settings.maxHeightError <= 0.f)) return stats;
+
+	// Triangles around every vertex, and a quadric per vertex from the planes of those triangles
+	std::vector<std::vector<uint32_t>> vertexTriangles(vertices.size());
+	std::vector<Quadric> quadrics(vertices.size());
+	for (size_t triangle = 0; triangle < triangleCount; ++triangle)
+	{
+		const glm::vec3& p0 = vertices[indices[triangle * 3]].mPosition;
+		const glm::vec3& p1 = vertices[indices[triangle * 3 + 1]].mPosition;
+		const glm::vec3& p2 = vertices[indices[triangle * 3 + 2]].mPosition;
+
+		// Plane scaled so its y coefficient is 1, evaluating it gives the vertical distance to the triangle
+		glm::dvec3 normal = glm::cross(glm::dvec3(p1 - p0), glm::dvec3(p2 - p0));
+		Quadric plane;
+		if (std::abs(normal.y) > 1e-12)
+		{
+			normal /= normal.y;
+			plane = Quadric(normal.x, 1.0, normal.z, -glm::dot(normal, glm::dvec3(p0)));
+		}
+
+		for (int corner = 0; corner < 3; ++corner)
+		{
+			Index vertex = indices[triangle * 3 + corner];
+			vertexTriangles[vertex].push_back(static_cast<uint32_t>(triangle));
+			quadrics[vertex] += plane;
+		}
+	}
+
+	std::vector<uint8_t> removedTriangles(triangleCount, 0);
+	std::vector<uint8_t> removedVertices(vertices.size(), 0);
+	std::vector<uint32_t> versions(vertices.size(), 0);
+	std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse>> collapses;
+
+	// Evaluates moving from onto to, false when the collapse would flip or flatten one of the triangles that are kept or go past the error bound
+	// On a grid the new triangles are checked against every original height under them, and that height error is the cost with the quadric
+	// as the tie-break. Ranking by the quadric alone, which only sees the kept vertex, let the surface between vertices drift far from the grid
+	auto EvaluateCollapse = [&](uint32_t from, uint32_t to, Collapse& collapse)
+		{
+			const glm::vec3& toPosition = vertices[to].mPosition;
+			float heightError = 0.f;
+			for (uint32_t triangle : vertexTriangles[from])
+			{
+				Index corners[3] = { indices[triangle * 3], indices[triangle * 3 + 1], indices[triangle * 3 + 2] };
+				if (corners[0] == to || corners[1] == to || corners[2] == to) continue;
+
+				float areaBefore = SignedAreaXZ(vertices[corners[0]].mPosition, vertices[corners[1]].mPosition, vertices[corners[2]].mPosition);
+				for (int corner = 0; corner < 3; ++corner)
+				{
+					if (corners[corner] == from) corners[corner] = to;
+				}
+				float areaAfter = SignedAreaXZ(vertices[corners[0]].mPosition, vertices[corners[1]].mPosition, vertices[corners[2]].mPosition);
+				if (areaBefore * areaAfter <= 0.f || std::abs(areaAfter) < std::abs(areaBefore) * 1e-4f) return false;
+
+				if (gridResolution > 0)
+				{
+					RasterizeGridTriangle(vertices, gridResolution, corners, [&](size_t vertexIndex, float surfaceHeight)
+						{
+							heightError = std::max(heightError, std::abs(surfaceHeight - vertices[vertexIndex].mPosition.y));
+						});
+					if (heightError > maxHeightError) return false;
+				}
+			}
+
+			Quadric merged = quadrics[from];
+			merged += quadrics[to];
+			double quadricCost = merged.Evaluate(toPosition);
+			if (gridResolution <= 0 && quadricCost > static_cast<double>(maxHeightError) * maxHeightError) return false;
+
+			collapse = { gridResolution > 0 ? static_cast<double>(heightError) * heightError : quadricCost, quadricCost, from, to, versions[from], versions[to] };
+			return true;
+		};
+
+	auto PushCollapse = [&](uint32_t from, uint32_t to)
+		{
+			Collapse collapse;
+			if (!lockedVertices[from] && EvaluateCollapse(from, to, collapse)) collapses.push(collapse);
+		};
+
+	auto CollectNeighbours = [&](uint32_t vertex, std::vector<uint32_t>& neighbours)
+		{
+			neighbours.clear();
+			for (uint32_t triangle : vertexTriangles[vertex])
+			{
+				for (int corner = 0; corner < 3; ++corner)
+				{
+					uint32_t other = indices[triangle * 3 + corner];
+					if (other != vertex) neighbours.push_back(other);
+				}
+			}
+			std::sort(neighbours.begin(), neighbours.end());
+			neighbours.erase(std::unique(neighbours.begin(), neighbours.end()), neighbours.end());
+		};
+
+	// Both directions of every edge are candidates, the edges shared by two triangles are pushed twice and the copy is dropped when popped
+	for (size_t triangle = 0; triangle < triangleCount; ++triangle)
+	{
+		for (int corner = 0; corner < 3; ++corner)
+		{
+			uint32_t first = indices[triangle * 3 + corner];
+			uint32_t second = indices[triangle * 3 + (corner + 1) % 3];
+			PushCollapse(first, second);
+			PushCollapse(second, first);
+		}
+	}
+
+	std::vector<uint32_t> fromNeighbours;
+	std::vector<uint32_t> toNeighbours;
+	std::vector<uint32_t> commonNeighbours;
+	size_t remainingTriangles = triangleCount;
+	while (!collapses.empty() && remainingTriangles > targetTriangles)
+	{
+		Collapse collapse = collapses.top();
+		collapses.pop();
+
+		uint32_t from = collapse.from;
+		uint32_t to = collapse.to;
+		if (removedVertices[from] || removedVertices[to] || versions[from] != collapse.fromVersion || versions[to] != collapse.toVersion) continue;
+
+		// The edge has to exist and be shared by two triangles, and the two vertices can only have the opposite corners of those in common
+		size_t sharedTriangles = 0;
+		for (uint32_t triangle : vertexTriangles[from])
+		{
+			const Index* corners = &indices[triangle * 3];
+			if (corners[0] == to || corners[1] == to || corners[2] == to) sharedTriangles++;
+		}
+		if (sharedTriangles != 2) continue;
+
+		CollectNeighbours(from, fromNeighbours);
+		CollectNeighbours(to, toNeighbours);
+		commonNeighbours.clear();
+		std::set_intersection(fromNeighbours.begin(), fromNeighbours.end(), toNeighbours.begin(), toNeighbours.end(), std::back_inserter(commonNeighbours));
+		if (commonNeighbours.size() != 2) continue;
+
+		// Collapses elsewhere may have reshaped the triangles around from since this one was queued, it goes back in the queue if it got worse
+		Collapse current;
+		if (!EvaluateCollapse(from, to, current)) continue;
+		if (current > collapse)
+		{
+			collapses.push(current);
+			continue;
+		}
+
+		// Collapsing, the two shared triangles go away and the rest of the from triangles are handed to the to vertex
+		for (uint32_t triangle : vertexTriangles[from])
+		{
+			Index* corners = &indices[triangle * 3];
+			if (corners[0] == to || corners[1] == to || corners[2] == to)
+			{
+				removedTriangles[triangle] = 1;
+				for (int corner = 0; corner < 3; ++corner)
+				{
+					if (corners[corner] == from) continue;
+					auto& triangles = vertexTriangles[corners[corner]];
+					triangles.erase(std::find(triangles.begin(), triangles.end(), triangle));
+				}
+				continue;
+			}
+			for (int corner = 0; corner < 3; ++corner)
+			{
+				if (corners[corner] == from) corners[corner] = to;
+			}
+			vertexTriangles[to].push_back(triangle);
+		}
+		vertexTriangles[from].clear();
+		vertexTriangles[from].shrink_to_fit();
+		removedVertices[from] = 1;
+		quadrics[to] += quadrics[from];
+		versions[to]++;
+		remainingTriangles -= sharedTriangles;
+		stats.collapses++;
+
+		// The merged quadric and the new triangles change the cost of every edge around the to vertex
+		CollectNeighbours(to, toNeighbours);
+		for (uint32_t neighbour : toNeighbours)
+		{
+			PushCollapse(neighbour, to);
+			PushCollapse(to, neighbour);
+		}
+	}
+
+	// Keeping the remaining triangles in their original order
+	size_t writeIndex = 0;
+	for (size_t triangle = 0; triangle < triangleCount; ++triangle)
+	{
+		if (removedTriangles[triangle]) continue;
+		for (int corner = 0; corner < 3; ++corner)
+		{
+			indices[writeIndex++] = indices[triangle * 3 + corner];
+		}
+	}
+	indices.resize(writeIndex);
+
+	stats.outputTriangles = remainingTriangles;
+	std::chrono::duration<double> elapsedTime = std::chrono::high_resolution_clock::now() - startTime;
+	stats.seconds = elapsedTime.count();
+	return stats;
+}
+
+void MeshSimplifier::MeasureGridHeightError(const std::vector<Vertex>& gridVertices, int resolution, const std::vector<Index>& indices, float& maxError, float& rmsError)
+{
+	maxError = 0.f;
+	rmsError = 0.f;
+	if (resolution <= 0) return;
+
+	// Every grid vertex is measured once, against the first triangle that covers it
+	std::vector<uint8_t> measured(gridVertices.size(), 0);
+	double squaredErrorSum = 0.0;
+	size_t measuredCount = 0;
+	for (size_t triangle = 0; triangle + 2 < indices.size(); triangle += 3)
+	{
+		RasterizeGridTriangle(gridVertices, resolution, &indices[triangle], [&](size_t vertexIndex, float surfaceHeight)
+			{
+				if (measured[vertexIndex]) return;
+				float error = std::abs(surfaceHeight - gridVertices[vertexIndex].mPosition.y);
+				maxError = std::max(maxError, error);
+				squaredErrorSum += static_cast<double>(error) * error;
+				measured[vertexIndex] = 1;
+				measuredCount++;
+			});
+	}
+	if (measuredCount > 0) rmsError = static_cast<float>(std::sqrt(squaredErrorSum / measuredCount));
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "utility/VariableTypes.h"
+
+class Vertex;
+
+// Stop conditions for MeshSimplifier::Simplify(), a 0 leaves that condition out
+struct SimplifySettings
+{
+	size_t targetTriangleCount{ 0 }; // Stops once the mesh is down to this many triangles
+	float maxHeightError{ 0.f }; // Skips collapses that would move the surface further than this from an original grid height
+};
+
+// Result of a simplification, the height errors are measured against the original grid heights
+struct SimplifyStats
+{
+	size_t inputTriangles{ 0 };
+	size_t outputTriangles{ 0 };
+	size_t collapses{ 0 };
+	float maxHeightError{ 0.f };
+	float rmsHeightError{ 0.f };
+	double seconds{ 0.0 };
+};
+
+/*
+ * Quadric error metric simplification by half-edge collapses (Garland/Heckbert), a vertex is merged into one of its neighbours so
+ * every kept vertex stays at its original position and the vertex buffer is not touched, only the index buffer shrinks
+ * The quadrics hold vertical distances to the triangle planes (y - ax - bz - c) instead of perpendicular ones, so the cost is a squared height error
+ * On a terrain grid the collapses are ranked by the exact height error of the new triangles against the original heights, with the quadric as the tie-break
+ * Collapses that would fold a triangle over in the xz plane or break the mesh topology are skipped, locked vertices are never removed
+ */
+class MeshSimplifier
+{
+public:
+	// gridResolution is the vertices per side when the vertices are a terrain grid (index i * resolution + j), 0 for any other mesh
+	static SimplifyStats Simplify(const std::vector<Vertex>& vertices, int gridResolution, std::vector<Index>& indices, const std::vector<uint8_t>& lockedVertices, const SimplifySettings& settings);
+
+	// Largest and root mean square difference between every grid vertex height and the simplified surface above or below it
+	static void MeasureGridHeightError(const std::vector<Vertex>& gridVertices, int resolution, const std::vector<Index>& indices, float& maxError, float& rmsError);
+};
@@ -0,0 +1,214 @@
+#include "PointCloudCache.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <limits>
+
+namespace
+{
+	constexpr size_t WriteBufferPoints = 1 << 16;
+
+	uint64_t AlignOffset(uint64_t offset)
+	{
+		return (offset + PointCloudCache::ArrayAlignment - 1) / PointCloudCache::ArrayAlignment * PointCloudCache::ArrayAlignment;
+	}
+
+	void HashBytes(uint64_t& hash, const void* data, size_t size)
+	{
+		// FNV-1a, 64 bit
+		const unsigned char* bytes = static_cast<const unsigned char*>(data);
+		for (size_t i = 0; i < size; ++i)
+		{
+			hash ^= bytes[i];
+			hash *= 1099511628211ull;
+		}
+	}
+
+	void WritePadding(std::ofstream& file, uint64_t currentOffset, uint64_t targetOffset)
+	{
+		static const char zeros[PointCloudCache::ArrayAlignment]{};
+		file.write(zeros, static_cast<std::streamsize>(targetOffset - currentOffset));
+	}
+}
+
+bool PointCloudCache::HashSourceFile(const std::string& sourcePath, uint64_t& sourceSize, uint64_t& sourceHash)
+{
+	// Hashing every byte of a multi-GB file would cost as much as parsing it, so the hash covers the size,
+	// the last write time and a fixed number of 4 KB samples spread over the file (always the first and last block)
+	MappedFile source(sourcePath);
+	if (!source.IsOpen()) return false;
+
+	std::error_code errorCode;
+	auto writeTime = std::filesystem::last_write_time(sourcePath, errorCode).time_since_epoch().count();
+
+	sourceSize = source.GetSize();
+	sourceHash = 14695981039346656037ull;
+	HashBytes(sourceHash, &sourceSize, sizeof(sourceSize));
+	HashBytes(sourceHash, &writeTime, sizeof(writeTime));
+
+	const size_t sampleSize = 4096;
+	const size_t sampleCount = 64;
+	if (sourceSize <= sampleSize * sampleCount)
+	{
+		HashBytes(sourceHash, source.GetData(), sourceSize);
+	}
+	else
+	{
+		for (size_t i = 0; i < sampleCount; ++i)
+		{
+			size_t sampleOffset = (sourceSize - sampleSize) / (sampleCount - 1) * i;
+			HashBytes(sourceHash, source.GetData() + sampleOffset, sampleSize);
+		}
+	}
+	return true;
+}
+
+bool PointCloudCacheWriter::Open(const std::string& cachePath, bool hasColors, uint64_t sourceSize, uint64_t sourceHash)
+{
+	mCachePath = cachePath;
+	mColorsPath = cachePath + ".colors.tmp";
+	mHeader = PointCloudCacheHeader();
+	mHeader.flags = hasColors ? static_cast<uint32_t>(HASCOLORS) : 0u;
+	mHeader.headerSize = sizeof(PointCloudCacheHeader);
+	mHeader.sourceSize = sourceSize;
+	mHeader.sourceHash = sourceHash;
+	mHeader.positionsOffset = AlignOffset(sizeof(PointCloudCacheHeader));
+	std::fill(std::begin(mHeader.boundsMin), std::end(mHeader.boundsMin), std::numeric_limits<float>::max());
+	std::fill(std::begin(mHeader.boundsMax), std::end(mHeader.boundsMax), std::numeric_limits<float>::lowest());
+
+	// Writing into a temporary file, it is only renamed to the cache path once it is complete
+	mFile.open(mCachePath + ".tmp", std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!mFile.is_open()) return false;
+
+	// Colors are stored after all positions, so they are streamed into a side file until Finish()
+	if (hasColors)
+	{
+		mColorsFile.open(mColorsPath, std::ios::out | std::ios::binary | std::ios::trunc);
+		if (!mColorsFile.is_open()) return false;
+	}
+
+	// Placeholder header, rewritten with the point count and bounds in Finish()
+	mFile.write(reinterpret_cast<const char*>(&mHeader), sizeof(PointCloudCacheHeader));
+	WritePadding(mFile, sizeof(PointCloudCacheHeader), mHeader.positionsOffset);
+
+	mPositionBuffer.reserve(WriteBufferPoints * 3);
+	mColorBuffer.reserve(hasColors ? WriteBufferPoints * 3 : 0);
+	return true;
+}
+
+void PointCloudCacheWriter::AddPoints(const float* positions, const float* colors, size_t pointCount)
+{
+	const bool hasColors = (mHeader.flags & HASCOLORS) != 0;
+	for (size_t i = 0; i < pointCount; ++i)
+	{
+		const float* position = positions + i * 3;
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			mHeader.boundsMin[axis] = std::min(mHeader.boundsMin[axis], position[axis]);
+			mHeader.boundsMax[axis] = std::max(mHeader.boundsMax[axis], position[axis]);
+		}
+	}
+
+	mPositionBuffer.insert(mPositionBuffer.end(), positions, positions + pointCount * 3);
+	if (hasColors)
+	{
+		mColorBuffer.insert(mColorBuffer.end(), colors, colors + pointCount * 3);
+	}
+	mHeader.pointCount += pointCount;
+
+	if (mPositionBuffer.size() >= WriteBufferPoints * 3)
+	{
+		FlushBuffers();
+	}
+}
+
+void PointCloudCacheWriter::FlushBuffers()
+{
+	mFile.write(reinterpret_cast<const char*>(mPositionBuffer.data()), static_cast<std::streamsize>(mPositionBuffer.size() * sizeof(float)));
+	mPositionBuffer.clear();
+	if (mColorsFile.is_open())
+	{
+		mColorsFile.write(reinterpret_cast<const char*>(mColorBuffer.data()), static_cast<std::streamsize>(mColorBuffer.size() * sizeof(float)));
+		mColorBuffer.clear();
+	}
+}
+
+bool PointCloudCacheWriter::Finish()
+{
+	FlushBuffers();
+	if (mHeader.pointCount == 0)
+	{
+		std::fill(std::begin(mHeader.boundsMin), std::end(mHeader.boundsMin), 0.f);
+		std::fill(std::begin(mHeader.boundsMax), std::end(mHeader.boundsMax), 0.f);
+	}
+
+	// Appending the colors after the positions
+	uint64_t positionsEnd = mHeader.positionsOffset + mHeader.pointCount * 3 * sizeof(float);
+	if (mColorsFile.is_open())
+	{
+		mColorsFile.close();
+		mHeader.colorsOffset = AlignOffset(positionsEnd);
+		WritePadding(mFile, positionsEnd, mHeader.colorsOffset);
+
+		std::ifstream colorsFile(mColorsPath, std::ios::in | std::ios::binary);
+		std::vector<char> copyBuffer(1 << 20);
+		while (colorsFile.read(copyBuffer.data(), copyBuffer.size()) || colorsFile.gcount() > 0)
+		{
+			mFile.write(copyBuffer.data(), colorsFile.gcount());
+		}
+		colorsFile.close();
+		std::filesystem::remove(mColorsPath);
+	}
+
+	mFile.seekp(0);
+	mFile.write(reinterpret_cast<const char*>(&mHeader), sizeof(PointCloudCacheHeader));
+	bool bIsWritten = mFile.good();
+	mFile.close();
+
+	std::error_code errorCode;
+	if (bIsWritten)
+	{
+		std::filesystem::rename(mCachePath + ".tmp", mCachePath, errorCode);
+	}
+	if (!bIsWritten || errorCode)
+	{
+		std::filesystem::remove(mCachePath + ".tmp", errorCode);
+		std::cerr << "Error writing point cloud cache: " << mCachePath << std::endl;
+		return false;
+	}
+	return true;
+}
+
+bool PointCloudCacheView::Open(const std::string& cachePath)
+{
+	mHeader = nullptr;
+	if (!mFile.Open(cachePath) || mFile.GetSize() < sizeof(PointCloudCacheHeader)) return false;
+
+	const PointCloudCacheHeader* header = reinterpret_cast<const PointCloudCacheHeader*>(mFile.GetData());
+	if (std::memcmp(header->magic, "PCBN", 4) != 0 || header->version != PointCloudCache::CurrentVersion || header->headerSize != sizeof(PointCloudCacheHeader))
+	{
+		return false;
+	}
+
+	// Making sure the arrays the header points to are actually inside the file
+	// Compared as a point count against the room after each offset, so a corrupt header cannot wrap the end offset around
+	const uint64_t fileSize = mFile.GetSize();
+	const uint64_t pointSize = 3 * sizeof(float);
+	auto FitsInFile = [&](uint64_t offset) { return offset <= fileSize && header->pointCount <= (fileSize - offset) / pointSize; };
+	if (!FitsInFile(header->positionsOffset) || ((header->flags & HASCOLORS) && !FitsInFile(header->colorsOffset))) return false;
+
+	mHeader = header;
+	return true;
+}
+
+void PointCloudCacheView::Close()
+{
+	mHeader = nullptr;
+	mFile.Close();
+}
+
+bool PointCloudCacheView::MatchesSource(uint64_t sourceSize, uint64_t sourceHash) const
+{
+	return mHeader != nullptr && mHeader->sourceSize == sourceSize && mHeader->sourceHash == sourceHash;
+}
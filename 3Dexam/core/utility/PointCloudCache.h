@@ -0,0 +1,99 @@
+#pragma once
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "MappedFile.h"
+
+/*
+ * Binary point-cloud format, written next to the text source the first time it is parsed
+ * Layout: header, positions (x, y, z floats per point), colors (r, g, b floats per point) when HASCOLORS is set
+ * Positions are stored after the y/z swap, so they can be used as vertex positions directly
+ */
+enum PointCloudCacheFlags : uint32_t
+{
+	HASCOLORS = 1 << 0
+};
+
+struct PointCloudCacheHeader
+{
+	char magic[4]{ 'P', 'C', 'B', 'N' };
+	uint32_t version{ 1 };
+	uint32_t flags{ 0 };
+	uint32_t headerSize{ 0 };
+	uint64_t pointCount{ 0 };
+	uint64_t sourceSize{ 0 };
+	uint64_t sourceHash{ 0 };
+	uint64_t positionsOffset{ 0 };
+	uint64_t colorsOffset{ 0 };
+	float boundsMin[3]{ 0.f, 0.f, 0.f };
+	float boundsMax[3]{ 0.f, 0.f, 0.f };
+};
+
+class PointCloudCache
+{
+public:
+	static constexpr uint32_t CurrentVersion = 1;
+	static constexpr uint64_t ArrayAlignment = 64;
+
+	/*
+	 * Source identification
+	 */
+	static std::string GetCachePath(const std::string& sourcePath) { return sourcePath + ".pcbin"; }
+	static bool IsBinaryPointFile(const std::string& path) { return path.size() >= 6 && path.compare(path.size() - 6, 6, ".pcbin") == 0; }
+	static bool HashSourceFile(const std::string& sourcePath, uint64_t& sourceSize, uint64_t& sourceHash);
+};
+
+/*
+ * Streaming writer, points can be added in any number of batches before Finish() writes the final header
+ */
+class PointCloudCacheWriter
+{
+public:
+	bool Open(const std::string& cachePath, bool hasColors, uint64_t sourceSize, uint64_t sourceHash);
+	void AddPoints(const float* positions, const float* colors, size_t pointCount);
+	bool Finish();
+
+private:
+	void FlushBuffers();
+
+	/*
+	 * Private Member Variables
+	 */
+	std::string mCachePath;
+	std::string mColorsPath;
+	std::ofstream mFile;
+	std::ofstream mColorsFile;
+	std::vector<float> mPositionBuffer;
+	std::vector<float> mColorBuffer;
+	PointCloudCacheHeader mHeader;
+};
+
+/*
+ * Memory-mapped read access to a cache file
+ */
+class PointCloudCacheView
+{
+public:
+	bool Open(const std::string& cachePath);
+	// Unmapping the file, needed before the cache at the same path can be replaced
+	void Close();
+	bool MatchesSource(uint64_t sourceSize, uint64_t sourceHash) const;
+
+	/*
+	 * Getters
+	 */
+	const PointCloudCacheHeader& GetHeader() const { return *mHeader; }
+	uint64_t GetPointCount() const { return mHeader->pointCount; }
+	bool HasColors() const { return (mHeader->flags & HASCOLORS) != 0; }
+	const float* GetPositions() const { return reinterpret_cast<const float*>(mFile.GetData() + mHeader->positionsOffset); }
+	const float* GetColors() const { return HasColors() ? reinterpret_cast<const float*>(mFile.GetData() + mHeader->colorsOffset) : nullptr; }
+
+private:
+	/*
+	 * Private Member Variables
+	 */
+	MappedFile mFile;
+	const PointCloudCacheHeader* mHeader{ nullptr };
+};
@@ -0,0 +1,250 @@
+#include "PointCloudConverter.h"
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <thread>
+#include <vector>
+
+#include "BoundedQueue.h"
+#include "PointCloudCache.h"
+#include "PointCloudParser.h"
+
+namespace
+{
+	struct TextBlock
+	{
+		uint64_t sequence{ 0 };
+		uint64_t firstLineIndex{ 0 };
+		std::string data;
+	};
+
+	struct OutputBlock
+	{
+		uint64_t sequence{ 0 };
+		uint64_t pointCount{ 0 };
+		std::string text;
+		std::vector<float> positions;
+		std::vector<float> colors;
+	};
+
+	constexpr int MaxValuesPerLine = 32;
+
+	// The output is written in binary mode, so the line break the old text mode fstream got from std::endl is written out as is
+#ifdef _WIN32
+	constexpr const char* LineBreak = "\r\n";
+#else
+	constexpr const char* LineBreak = "\n";
+#endif
+
+	bool IsLineKept(uint64_t lineIndex)
+	{
+		// The first line is a header, after that only every other line holds a point
+		return lineIndex % 2 == 1;
+	}
+
+	void ReadBlocks(std::ifstream& input, size_t blockSize, BoundedQueue<TextBlock>& textBlocks, uint64_t& bytesRead)
+	{
+		uint64_t sequence = 0;
+		uint64_t lineIndex = 0;
+		std::string carry;
+		bool bIsEndOfFile = false;
+
+		while (!bIsEndOfFile)
+		{
+			TextBlock block;
+			block.data = std::move(carry);
+			carry.clear();
+			size_t previousSize = block.data.size();
+			block.data.resize(previousSize + blockSize);
+			input.read(block.data.data() + previousSize, static_cast<std::streamsize>(blockSize));
+			size_t readSize = static_cast<size_t>(input.gcount());
+			block.data.resize(previousSize + readSize);
+			bytesRead += readSize;
+			bIsEndOfFile = readSize < blockSize;
+
+			// Keeping the unfinished last line for the next block
+			if (!bIsEndOfFile)
+			{
+				size_t lastNewLine = block.data.rfind('\n');
+				if (lastNewLine == std::string::npos)
+				{
+					carry = std::move(block.data);
+					continue;
+				}
+				carry.assign(block.data, lastNewLine + 1, std::string::npos);
+				block.data.resize(lastNewLine + 1);
+			}
+			if (block.data.empty()) break;
+
+			block.sequence = sequence++;
+			block.firstLineIndex = lineIndex;
+			lineIndex += std::count(block.data.begin(), block.data.end(), '\n');
+			if (block.data.back() != '\n') lineIndex++;
+
+			if (!textBlocks.Push(std::move(block))) break;
+		}
+	}
+
+	void TransformBlock(TextBlock& block, bool writeBinary, bool usingColors, OutputBlock& output)
+	{
+		output.sequence = block.sequence;
+		float values[MaxValuesPerLine];
+		const int valuesPerPoint = usingColors ? 6 : 3;
+
+		char* lineStart = block.data.data();
+		char* blockEnd = lineStart + block.data.size();
+		uint64_t lineIndex = block.firstLineIndex;
+		while (lineStart < blockEnd)
+		{
+			char* lineEnd = std::find(lineStart, blockEnd, '\n');
+			if (IsLineKept(lineIndex))
+			{
+				// Cleaning the line in place, the block is owned by this stage
+				size_t cleanedSize = PointCloudParser::RemoveUnwantedChars(lineStart, lineEnd - lineStart);
+				const char* cursor = lineStart;
+				int valueCount = PointCloudParser::ParseLine(cursor, lineStart + cleanedSize, values, MaxValuesPerLine);
+
+				if (writeBinary)
+				{
+					if (valueCount >= valuesPerPoint)
+					{
+						// Same y/z swap as the text loader, so the binary file holds vertex positions
+						output.positions.insert(output.positions.end(), { values[0], values[2], values[1] });
+						if (usingColors) output.colors.insert(output.colors.end(), values + 3, values + 6);
+						output.pointCount++;
+					}
+				}
+				else
+				{
+					// Same "%.4f " formatting as the fstream based converter
+					char number[64];
+					for (int i = 0; i < valueCount; ++i)
+					{
+						auto [numberEnd, errorCode] = std::to_chars(number, number + sizeof(number), values[i], std::chars_format::fixed, 4);
+						output.text.append(number, numberEnd);
+						output.text.push_back(' ');
+					}
+					output.text.append(LineBreak);
+					output.pointCount++;
+				}
+			}
+
+			lineStart = lineEnd + 1;
+			lineIndex++;
+		}
+	}
+}
+
+bool PointCloudConverter::Convert(const PointCloudConvertSettings& settings)
+{
+	std::ifstream input(settings.inputPath, std::ios::in | std::ios::binary);
+	if (!input.is_open())
+	{
+		std::cerr << "Error opening files." << std::endl;
+		return false;
+	}
+
+	std::ofstream textOutput;
+	PointCloudCacheWriter binaryOutput;
+	if (settings.writeBinary)
+	{
+		uint64_t sourceSize = 0;
+		uint64_t sourceHash = 0;
+		// The header ties the binary file to its source, a file written with a made up hash could later be taken as current
+		if (!PointCloudCache::HashSourceFile(settings.inputPath, sourceSize, sourceHash))
+		{
+			std::cerr << "Error hashing source file: " << settings.inputPath << std::endl;
+			return false;
+		}
+		if (!binaryOutput.Open(settings.outputPath, settings.usingColors, sourceSize, sourceHash))
+		{
+			std::cerr << "Error opening files." << std::endl;
+			return false;
+		}
+	}
+	else
+	{
+		textOutput.open(settings.outputPath, std::ios::out | std::ios::binary | std::ios::trunc);
+		if (!textOutput.is_open())
+		{
+			std::cerr << "Error opening files." << std::endl;
+			return false;
+		}
+	}
+
+	std::cout << "Reading file: " << settings.inputPath << std::endl;
+	std::cout << "Starting to write into new file: " << settings.outputPath << std::endl;
+	auto startTime = std::chrono::high_resolution_clock::now();
+
+	BoundedQueue<TextBlock> textBlocks(settings.queueCapacity);
+	BoundedQueue<OutputBlock> outputBlocks(settings.queueCapacity);
+	uint64_t bytesRead = 0;
+	uint64_t pointsWritten = 0;
+
+	// Stage 1, reading blocks that end on a line break
+	std::thread readerThread([&]()
+		{
+			ReadBlocks(input, settings.blockSize, textBlocks, bytesRead);
+			textBlocks.Close();
+		});
+
+	// Stage 2, cleaning and parsing, several threads can work on different blocks
+	std::vector<std::thread> transformThreads;
+	unsigned int transformThreadCount = std::max(settings.transformThreads, 1u);
+	for (unsigned int i = 0; i < transformThreadCount; ++i)
+	{
+		transformThreads.emplace_back([&]()
+			{
+				TextBlock block;
+				while (textBlocks.Pop(block))
+				{
+					OutputBlock output;
+					TransformBlock(block, settings.writeBinary, settings.usingColors, output);
+					outputBlocks.Push(std::move(output));
+				}
+			});
+	}
+	std::thread closeThread([&]()
+		{
+			for (auto& thread : transformThreads) thread.join();
+			outputBlocks.Close();
+		});
+
+	// Stage 3, writing on this thread, blocks are put back into file order before they are written
+	std::map<uint64_t, OutputBlock> waitingBlocks;
+	uint64_t nextSequence = 0;
+	OutputBlock output;
+	while (outputBlocks.Pop(output))
+	{
+		waitingBlocks.emplace(output.sequence, std::move(output));
+		for (auto it = waitingBlocks.find(nextSequence); it != waitingBlocks.end(); it = waitingBlocks.find(++nextSequence))
+		{
+			OutputBlock& block = it->second;
+			if (settings.writeBinary)
+			{
+				binaryOutput.AddPoints(block.positions.data(), block.colors.data(), block.pointCount);
+			}
+			else
+			{
+				textOutput.write(block.text.data(), static_cast<std::streamsize>(block.text.size()));
+			}
+			pointsWritten += block.pointCount;
+			waitingBlocks.erase(it);
+		}
+	}
+
+	readerThread.join();
+	closeThread.join();
+
+	bool bIsWritten = settings.writeBinary ? binaryOutput.Finish() : textOutput.good();
+	textOutput.close();
+
+	std::chrono::duration<double> elapsedTime = std::chrono::high_resolution_clock::now() - startTime;
+	double sizeMB = bytesRead / (1024.0 * 1024.0);
+	std::cout << "Converted " << pointsWritten << " points from " << sizeMB << " MB in " << elapsedTime.count() << " s ("
+		<< sizeMB / std::max(elapsedTime.count(), 1e-9) << " MB/s)\n";
+	return bIsWritten;
+}
@@ -0,0 +1,27 @@
+#pragma once
+#include <cstddef>
+#include <string>
+
+/*
+ * Settings for converting raw LAS text exports ("x: 1.0, y: 2.0, z: 3.0, r: ...") into terrain point data
+ */
+struct PointCloudConvertSettings
+{
+	std::string inputPath;
+	std::string outputPath;
+	bool writeBinary{ false }; // Writes the binary point format (.pcbin) instead of cleaned text
+	bool usingColors{ true };
+	unsigned int transformThreads{ 1 }; // Number of clean/parse threads between the reader and the writer
+	size_t blockSize{ 4 << 20 }; // Bytes read per block
+	size_t queueCapacity{ 8 }; // Blocks allowed to wait between two stages
+};
+
+/*
+ * Offline conversion, runs as a reader -> clean/parse -> writer pipeline with one thread per stage
+ * Like ReadWriteFiles::ReadFromFileWriteIntoNewFile, the first line is skipped and after that every other line is kept
+ */
+class PointCloudConverter
+{
+public:
+	static bool Convert(const PointCloudConvertSettings& settings);
+};
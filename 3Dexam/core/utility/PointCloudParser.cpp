@@ -0,0 +1,102 @@
+#include "PointCloudParser.h"
+#include <charconv>
+#include <cstring>
+#include <string_view>
+
+int PointCloudParser::ParseLine(const char*& cursor, const char* end, float* values, int maxValues)
+{
+	// Finding the end of the line, memchr is a lot faster than checking each char in the loop
+	const char* lineEnd = static_cast<const char*>(std::memchr(cursor, '\n', end - cursor));
+	if (lineEnd == nullptr) lineEnd = end;
+
+	int valueCount = 0;
+	const char* position = cursor;
+	while (position < lineEnd)
+	{
+		// Skipping whitespace between the numbers
+		char character = *position;
+		if (character == ' ' || character == '\t' || character == '\r' || character == '\v' || character == '\f')
+		{
+			++position;
+			continue;
+		}
+
+		// std::from_chars does not accept a leading '+', std::istream does
+		if (character == '+') ++position;
+
+		float number;
+		auto [parseEnd, errorCode] = std::from_chars(position, lineEnd, number);
+		if (errorCode != std::errc()) break;
+
+		if (valueCount < maxValues)
+		{
+			values[valueCount] = number;
+		}
+		++valueCount;
+		position = parseEnd;
+	}
+
+	cursor = (lineEnd < end) ? lineEnd + 1 : end;
+	return valueCount < maxValues ? valueCount : maxValues;
+}
+
+size_t PointCloudParser::CountLines(const char* begin, const char* end)
+{
+	size_t lineCount = 0;
+	const char* position = begin;
+	while (position < end)
+	{
+		const char* newLine = static_cast<const char*>(std::memchr(position, '\n', end - position));
+		lineCount++;
+		if (newLine == nullptr) break;
+		position = newLine + 1;
+	}
+	return lineCount;
+}
+
+size_t PointCloudParser::RemoveUnwantedChars(char* data, size_t size)
+{
+	// Lookup table of the characters to remove: x, y, z, r, g, b, u, v, ':', ',' and 'f'
+	static const auto unwantedChars = []()
+		{
+			struct CharTable { bool isUnwanted[256]{}; } table;
+			for (unsigned char character : std::string_view("xyzrgbuv:,f"))
+			{
+				table.isUnwanted[character] = true;
+			}
+			return table;
+		}();
+
+	size_t writeIndex = 0;
+	for (size_t readIndex = 0; readIndex < size; ++readIndex)
+	{
+		char character = data[readIndex];
+		data[writeIndex] = character;
+		writeIndex += unwantedChars.isUnwanted[static_cast<unsigned char>(character)] ? 0 : 1;
+	}
+	return writeIndex;
+}
+
+std::vector<const char*> PointCloudParser::SplitIntoLineChunks(const char* begin, const char* end, size_t chunkCount)
+{
+	std::vector<const char*> boundaries{ begin };
+	size_t totalSize = end - begin;
+	chunkCount = chunkCount > 0 ? chunkCount : 1;
+
+	for (size_t i = 1; i < chunkCount; ++i)
+	{
+		// Moving each even split point forward to the start of the next line
+		const char* splitPoint = begin + totalSize * i / chunkCount;
+		if (splitPoint <= boundaries.back()) continue;
+
+		const char* newLine = static_cast<const char*>(std::memchr(splitPoint - 1, '\n', end - (splitPoint - 1)));
+		if (newLine == nullptr) break;
+		if (newLine + 1 > boundaries.back() && newLine + 1 < end)
+		{
+			boundaries.push_back(newLine + 1);
+		}
+	}
+
+	boundaries.push_back(end);
+	return boundaries;
+}
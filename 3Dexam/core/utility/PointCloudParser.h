@@ -0,0 +1,19 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+/*
+ * In-place parsing of whitespace separated point-cloud text, meant to run directly on a memory-mapped file
+ */
+class PointCloudParser
+{
+public:
+	// Parses the numbers of the line starting at cursor, stops at the first token that is not a number (like std::istream)
+	// Returns how many values were parsed, at most maxValues are stored. The cursor is moved to the start of the next line
+	static int ParseLine(const char*& cursor, const char* end, float* values, int maxValues);
+	static size_t CountLines(const char* begin, const char* end);
+	// Removes the labels and separators of raw LAS text exports ("x: 1.0, y: 2.0, ...") in one pass, returns the new size
+	static size_t RemoveUnwantedChars(char* data, size_t size);
+	// Splits the range into about chunkCount pieces that all start at the beginning of a line, returns chunk boundaries
+	static std::vector<const char*> SplitIntoLineChunks(const char* begin, const char* end, size_t chunkCount);
+};
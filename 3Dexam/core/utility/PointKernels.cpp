@@ -0,0 +1,541 @@
+#include "PointKernels.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define POINTKERNELS_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define POINTKERNELS_TARGET(instructionSet)
+#else
+#include <cpuid.h>
+#define POINTKERNELS_TARGET(instructionSet) __attribute__((target(instructionSet)))
+#endif
+#endif
+
+namespace
+{
+	/*
+	 * Scalar kernels, also used for the tails the vector kernels leave over
+	 */
+	void BoundsScalar(const float* x, const float* z, size_t begin, size_t count, PointBoundsXZ& bounds)
+	{
+		for (size_t i = begin; i < count; ++i)
+		{
+			bounds.minX = bounds.minX < x[i] ? bounds.minX : x[i];
+			bounds.maxX = bounds.maxX > x[i] ? bounds.maxX : x[i];
+			bounds.minZ = bounds.minZ < z[i] ? bounds.minZ : z[i];
+			bounds.maxZ = bounds.maxZ > z[i] ? bounds.maxZ : z[i];
+		}
+	}
+
+	void TranslateScalar(float* x, float* z, size_t begin, size_t count, float offsetX, float offsetZ)
+	{
+		for (size_t i = begin; i < count; ++i)
+		{
+			x[i] -= offsetX;
+			z[i] -= offsetZ;
+		}
+	}
+
+	void CellIndicesScalar(const float* x, const float* z, size_t begin, size_t count, float originX, float originZ, float inverseCellSize, int cellsX, int cellsZ, uint32_t* cells)
+	{
+		for (size_t i = begin; i < count; ++i)
+		{
+			int cellX = PointKernels::GetCellCoordinate(x[i], originX, inverseCellSize, cellsX);
+			int cellZ = PointKernels::GetCellCoordinate(z[i], originZ, inverseCellSize, cellsZ);
+			cells[i] = static_cast<uint32_t>(cellX * cellsZ + cellZ);
+		}
+	}
+
+	void GridTrianglesScalar(const float* x, const float* z, size_t begin, size_t count, const GridSampleLayout& grid, float* heights, float* normals, uint8_t* hits)
+	{
+		const int cells = grid.resolution - 1;
+		const float lastCell = static_cast<float>(cells - 1);
+		for (size_t i = begin; i < count; ++i)
+		{
+			float gridX = (x[i] - grid.originX) * grid.inverseSpacingX;
+			float gridZ = (z[i] - grid.originZ) * grid.inverseSpacingZ;
+			hits[i] = gridX >= -grid.edgeTolerance && gridX <= cells + grid.edgeTolerance && gridZ >= -grid.edgeTolerance && gridZ <= cells + grid.edgeTolerance;
+
+			float clampedX = gridX > 0.f ? gridX : 0.f;
+			float clampedZ = gridZ > 0.f ? gridZ : 0.f;
+			int cellI = static_cast<int>(clampedX < lastCell ? clampedX : lastCell);
+			int cellJ = static_cast<int>(clampedZ < lastCell ? clampedZ : lastCell);
+			float cellX = gridX - static_cast<float>(cellI);
+			float cellZ = gridZ - static_cast<float>(cellJ);
+			cellX = cellX > 0.f ? (cellX < 1.f ? cellX : 1.f) : 0.f;
+			cellZ = cellZ > 0.f ? (cellZ < 1.f ? cellZ : 1.f) : 0.f;
+
+			// The first cell triangle is (i, j), (i + 1, j), (i, j + 1), the second (i + 1, j), (i + 1, j + 1), (i, j + 1)
+			int index0 = cellI * grid.resolution + cellJ;
+			int index1 = index0 + grid.resolution;
+			int index2 = index0 + 1;
+			bool upper = cellX + cellZ > 1.f;
+			int corners[3] = { upper ? index1 : index0, upper ? index1 + 1 : index1, index2 };
+			float weights[3] = { upper ? 1.f - cellZ : 1.f - cellX - cellZ, upper ? cellX + cellZ - 1.f : cellX, upper ? 1.f - cellX : cellZ };
+
+			heights[i] = weights[0] * grid.heights[corners[0]] + weights[1] * grid.heights[corners[1]] + weights[2] * grid.heights[corners[2]];
+			if (!normals) continue;
+
+			float normal[3];
+			for (int axis = 0; axis < 3; ++axis)
+			{
+				normal[axis] = weights[0] * grid.normals[corners[0] * 3 + axis] + weights[1] * grid.normals[corners[1] * 3 + axis] + weights[2] * grid.normals[corners[2] * 3 + axis];
+			}
+			float inverseLength = 1.f / std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+			for (int axis = 0; axis < 3; ++axis)
+			{
+				normals[i * 3 + axis] = normal[axis] * inverseLength;
+			}
+		}
+	}
+
+#ifdef POINTKERNELS_X86
+	/*
+	 * SSE4.1 kernels, 4 points per step
+	 */
+	POINTKERNELS_TARGET("sse4.1")
+	void BoundsSSE41(const float* x, const float* z, size_t count, PointBoundsXZ& bounds)
+	{
+		__m128 minX = _mm_set1_ps(bounds.minX);
+		__m128 maxX = _mm_set1_ps(bounds.maxX);
+		__m128 minZ = _mm_set1_ps(bounds.minZ);
+		__m128 maxZ = _mm_set1_ps(bounds.maxZ);
+		size_t i = 0;
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128 valueX = _mm_loadu_ps(x + i);
+			__m128 valueZ = _mm_loadu_ps(z + i);
+			minX = _mm_min_ps(minX, valueX);
+			maxX = _mm_max_ps(maxX, valueX);
+			minZ = _mm_min_ps(minZ, valueZ);
+			maxZ = _mm_max_ps(maxZ, valueZ);
+		}
+
+		alignas(16) float lanes[4][4];
+		_mm_store_ps(lanes[0], minX);
+		_mm_store_ps(lanes[1], maxX);
+		_mm_store_ps(lanes[2], minZ);
+		_mm_store_ps(lanes[3], maxZ);
+		for (int lane = 0; lane < 4; ++lane)
+		{
+			bounds.minX = bounds.minX < lanes[0][lane] ? bounds.minX : lanes[0][lane];
+			bounds.maxX = bounds.maxX > lanes[1][lane] ? bounds.maxX : lanes[1][lane];
+			bounds.minZ = bounds.minZ < lanes[2][lane] ? bounds.minZ : lanes[2][lane];
+			bounds.maxZ = bounds.maxZ > lanes[3][lane] ? bounds.maxZ : lanes[3][lane];
+		}
+		BoundsScalar(x, z, i, count, bounds);
+	}
+
+	POINTKERNELS_TARGET("sse4.1")
+	void TranslateSSE41(float* x, float* z, size_t count, float offsetX, float offsetZ)
+	{
+		__m128 subtractX = _mm_set1_ps(offsetX);
+		__m128 subtractZ = _mm_set1_ps(offsetZ);
+		size_t i = 0;
+		for (; i + 4 <= count; i += 4)
+		{
+			_mm_storeu_ps(x + i, _mm_sub_ps(_mm_loadu_ps(x + i), subtractX));
+			_mm_storeu_ps(z + i, _mm_sub_ps(_mm_loadu_ps(z + i), subtractZ));
+		}
+		TranslateScalar(x, z, i, count, offsetX, offsetZ);
+	}
+
+	POINTKERNELS_TARGET("sse4.1")
+	void CellIndicesSSE41(const float* x, const float* z, size_t count, float originX, float originZ, float inverseCellSize, int cellsX, int cellsZ, uint32_t* cells)
+	{
+		__m128 vectorOriginX = _mm_set1_ps(originX);
+		__m128 vectorOriginZ = _mm_set1_ps(originZ);
+		__m128 inverse = _mm_set1_ps(inverseCellSize);
+		__m128 zero = _mm_setzero_ps();
+		__m128 lastCellX = _mm_set1_ps(static_cast<float>(cellsX - 1));
+		__m128 lastCellZ = _mm_set1_ps(static_cast<float>(cellsZ - 1));
+		__m128i rowLength = _mm_set1_epi32(cellsZ);
+		size_t i = 0;
+		for (; i + 4 <= count; i += 4)
+		{
+			// Clamping before the truncation keeps every value in int range and makes truncation equal floor
+			__m128 cellX = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(x + i), vectorOriginX), inverse);
+			__m128 cellZ = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(z + i), vectorOriginZ), inverse);
+			cellX = _mm_min_ps(_mm_max_ps(cellX, zero), lastCellX);
+			cellZ = _mm_min_ps(_mm_max_ps(cellZ, zero), lastCellZ);
+			__m128i cell = _mm_add_epi32(_mm_mullo_epi32(_mm_cvttps_epi32(cellX), rowLength), _mm_cvttps_epi32(cellZ));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(cells + i), cell);
+		}
+		CellIndicesScalar(x, z, i, count, originX, originZ, inverseCellSize, cellsX, cellsZ, cells);
+	}
+
+	POINTKERNELS_TARGET("sse4.1")
+	void GridTrianglesSSE41(const float* x, const float* z, size_t count, const GridSampleLayout& grid, float* heights, float* normals, uint8_t* hits)
+	{
+		const int cells = grid.resolution - 1;
+		__m128 originX = _mm_set1_ps(grid.originX);
+		__m128 originZ = _mm_set1_ps(grid.originZ);
+		__m128 inverseX = _mm_set1_ps(grid.inverseSpacingX);
+		__m128 inverseZ = _mm_set1_ps(grid.inverseSpacingZ);
+		__m128 lowLimit = _mm_set1_ps(-grid.edgeTolerance);
+		__m128 highLimit = _mm_set1_ps(cells + grid.edgeTolerance);
+		__m128 zero = _mm_setzero_ps();
+		__m128 one = _mm_set1_ps(1.f);
+		__m128 lastCell = _mm_set1_ps(static_cast<float>(cells - 1));
+		__m128i rowLength = _mm_set1_epi32(grid.resolution);
+		__m128i next = _mm_set1_epi32(1);
+		size_t i = 0;
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128 gridX = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(x + i), originX), inverseX);
+			__m128 gridZ = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(z + i), originZ), inverseZ);
+			__m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(gridX, lowLimit), _mm_cmple_ps(gridX, highLimit)),
+				_mm_and_ps(_mm_cmpge_ps(gridZ, lowLimit), _mm_cmple_ps(gridZ, highLimit)));
+
+			__m128i cellI = _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(gridX, zero), lastCell));
+			__m128i cellJ = _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(gridZ, zero), lastCell));
+			__m128 cellX = _mm_min_ps(_mm_max_ps(_mm_sub_ps(gridX, _mm_cvtepi32_ps(cellI)), zero), one);
+			__m128 cellZ = _mm_min_ps(_mm_max_ps(_mm_sub_ps(gridZ, _mm_cvtepi32_ps(cellJ)), zero), one);
+
+			__m128i index0 = _mm_add_epi32(_mm_mullo_epi32(cellI, rowLength), cellJ);
+			__m128i index1 = _mm_add_epi32(index0, rowLength);
+			__m128i index2 = _mm_add_epi32(index0, next);
+			__m128 upper = _mm_cmpgt_ps(_mm_add_ps(cellX, cellZ), one);
+			__m128i upperMask = _mm_castps_si128(upper);
+			__m128i corners[3] = { _mm_blendv_epi8(index0, index1, upperMask), _mm_blendv_epi8(index1, _mm_add_epi32(index1, next), upperMask), index2 };
+			__m128 weights[3] = {
+				_mm_blendv_ps(_mm_sub_ps(_mm_sub_ps(one, cellX), cellZ), _mm_sub_ps(one, cellZ), upper),
+				_mm_blendv_ps(cellX, _mm_sub_ps(_mm_add_ps(cellX, cellZ), one), upper),
+				_mm_blendv_ps(cellZ, _mm_sub_ps(one, cellX), upper) };
+
+			// SSE has no gather, the corner values are loaded lane by lane
+			alignas(16) int cornerLanes[3][4];
+			for (int corner = 0; corner < 3; ++corner)
+			{
+				_mm_store_si128(reinterpret_cast<__m128i*>(cornerLanes[corner]), corners[corner]);
+			}
+			auto Gather = [&](const float* values, int corner, int stride, int offset)
+				{
+					const int* lanes = cornerLanes[corner];
+					return _mm_setr_ps(values[lanes[0] * stride + offset], values[lanes[1] * stride + offset], values[lanes[2] * stride + offset], values[lanes[3] * stride + offset]);
+				};
+
+			__m128 height = _mm_add_ps(_mm_add_ps(_mm_mul_ps(weights[0], Gather(grid.heights, 0, 1, 0)), _mm_mul_ps(weights[1], Gather(grid.heights, 1, 1, 0))),
+				_mm_mul_ps(weights[2], Gather(grid.heights, 2, 1, 0)));
+			_mm_storeu_ps(heights + i, height);
+			int insideBits = _mm_movemask_ps(inside);
+			for (int lane = 0; lane < 4; ++lane)
+			{
+				hits[i + lane] = static_cast<uint8_t>((insideBits >> lane) & 1);
+			}
+			if (!normals) continue;
+
+			__m128 normal[3];
+			for (int axis = 0; axis < 3; ++axis)
+			{
+				normal[axis] = _mm_add_ps(_mm_add_ps(_mm_mul_ps(weights[0], Gather(grid.normals, 0, 3, axis)), _mm_mul_ps(weights[1], Gather(grid.normals, 1, 3, axis))),
+					_mm_mul_ps(weights[2], Gather(grid.normals, 2, 3, axis)));
+			}
+			__m128 lengthSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(normal[0], normal[0]), _mm_mul_ps(normal[1], normal[1])), _mm_mul_ps(normal[2], normal[2]));
+			__m128 inverseLength = _mm_div_ps(one, _mm_sqrt_ps(lengthSquared));
+			alignas(16) float normalLanes[3][4];
+			for (int axis = 0; axis < 3; ++axis)
+			{
+				_mm_store_ps(normalLanes[axis], _mm_mul_ps(normal[axis], inverseLength));
+			}
+			for (int lane = 0; lane < 4; ++lane)
+			{
+				for (int axis = 0; axis < 3; ++axis)
+				{
+					normals[(i + lane) * 3 + axis] = normalLanes[axis][lane];
+				}
+			}
+		}
+		GridTrianglesScalar(x, z, i, count, grid, heights, normals, hits);
+	}
+
+	/*
+	 * AVX2 kernels, 8 points per step
+	 */
+	POINTKERNELS_TARGET("avx2")
+	void BoundsAVX2(const float* x, const float* z, size_t count, PointBoundsXZ& bounds)
+	{
+		__m256 minX = _mm256_set1_ps(bounds.minX);
+		__m256 maxX = _mm256_set1_ps(bounds.maxX);
+		__m256 minZ = _mm256_set1_ps(bounds.minZ);
+		__m256 maxZ = _mm256_set1_ps(bounds.maxZ);
+		size_t i = 0;
+		for (; i + 8 <= count; i += 8)
+		{
+			__m256 valueX = _mm256_loadu_ps(x + i);
+			__m256 valueZ = _mm256_loadu_ps(z + i);
+			minX = _mm256_min_ps(minX, valueX);
+			maxX = _mm256_max_ps(maxX, valueX);
+			minZ = _mm256_min_ps(minZ, valueZ);
+			maxZ = _mm256_max_ps(maxZ, valueZ);
+		}
+
+		alignas(32) float lanes[4][8];
+		_mm256_store_ps(lanes[0], minX);
+		_mm256_store_ps(lanes[1], maxX);
+		_mm256_store_ps(lanes[2], minZ);
+		_mm256_store_ps(lanes[3], maxZ);
+		for (int lane = 0; lane < 8; ++lane)
+		{
+			bounds.minX = bounds.minX < lanes[0][lane] ? bounds.minX : lanes[0][lane];
+			bounds.maxX = bounds.maxX > lanes[1][lane] ? bounds.maxX : lanes[1][lane];
+			bounds.minZ = bounds.minZ < lanes[2][lane] ? bounds.minZ : lanes[2][lane];
+			bounds.maxZ = bounds.maxZ > lanes[3][lane] ? bounds.maxZ : lanes[3][lane];
+		}
+		BoundsScalar(x, z, i, count, bounds);
+	}
+
+	POINTKERNELS_TARGET("avx2")
+	void TranslateAVX2(float* x, float* z, size_t count, float offsetX, float offsetZ)
+	{
+		__m256 subtractX = _mm256_set1_ps(offsetX);
+		__m256 subtractZ = _mm256_set1_ps(offsetZ);
+		size_t i = 0;
+		for (; i + 8 <= count; i += 8)
+		{
+			_mm256_storeu_ps(x + i, _mm256_sub_ps(_mm256_loadu_ps(x + i), subtractX));
+			_mm256_storeu_ps(z + i, _mm256_sub_ps(_mm256_loadu_ps(z + i), subtractZ));
+		}
+		TranslateScalar(x, z, i, count, offsetX, offsetZ);
+	}
+
+	POINTKERNELS_TARGET("avx2")
+	void CellIndicesAVX2(const float* x, const float* z, size_t count, float originX, float originZ, float inverseCellSize, int cellsX, int cellsZ, uint32_t* cells)
+	{
+		__m256 vectorOriginX = _mm256_set1_ps(originX);
+		__m256 vectorOriginZ = _mm256_set1_ps(originZ);
+		__m256 inverse = _mm256_set1_ps(inverseCellSize);
+		__m256 zero = _mm256_setzero_ps();
+		__m256 lastCellX = _mm256_set1_ps(static_cast<float>(cellsX - 1));
+		__m256 lastCellZ = _mm256_set1_ps(static_cast<float>(cellsZ - 1));
+		__m256i rowLength = _mm256_set1_epi32(cellsZ);
+		size_t i = 0;
+		for (; i + 8 <= count; i += 8)
+		{
+			__m256 cellX = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(x + i), vectorOriginX), inverse);
+			__m256 cellZ = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(z + i), vectorOriginZ), inverse);
+			cellX = _mm256_min_ps(_mm256_max_ps(cellX, zero), lastCellX);
+			cellZ = _mm256_min_ps(_mm256_max_ps(cellZ, zero), lastCellZ);
+			__m256i cell = _mm256_add_epi32(_mm256_mullo_epi32(_mm256_cvttps_epi32(cellX), rowLength), _mm256_cvttps_epi32(cellZ));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(cells + i), cell);
+		}
+		CellIndicesScalar(x, z, i, count, originX, originZ, inverseCellSize, cellsX, cellsZ, cells);
+	}
+
+	POINTKERNELS_TARGET("avx2")
+	void GridTrianglesAVX2(const float* x, const float* z, size_t count, const GridSampleLayout& grid, float* heights, float* normals, uint8_t* hits)
+	{
+		const int cells = grid.resolution - 1;
+		__m256 originX = _mm256_set1_ps(grid.originX);
+		__m256 originZ = _mm256_set1_ps(grid.originZ);
+		__m256 inverseX = _mm256_set1_ps(grid.inverseSpacingX);
+		__m256 inverseZ = _mm256_set1_ps(grid.inverseSpacingZ);
+		__m256 lowLimit = _mm256_set1_ps(-grid.edgeTolerance);
+		__m256 highLimit = _mm256_set1_ps(cells + grid.edgeTolerance);
+		__m256 zero = _mm256_setzero_ps();
+		__m256 one = _mm256_set1_ps(1.f);
+		__m256 lastCell = _mm256_set1_ps(static_cast<float>(cells - 1));
+		__m256i rowLength = _mm256_set1_epi32(grid.resolution);
+		__m256i next = _mm256_set1_epi32(1);
+		__m256i three = _mm256_set1_epi32(3);
+		size_t i = 0;
+		for (; i + 8 <= count; i += 8)
+		{
+			__m256 gridX = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(x + i), originX), inverseX);
+			__m256 gridZ = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(z + i), originZ), inverseZ);
+			__m256 inside = _mm256_and_ps(_mm256_and_ps(_mm256_cmp_ps(gridX, lowLimit, _CMP_GE_OQ), _mm256_cmp_ps(gridX, highLimit, _CMP_LE_OQ)),
+				_mm256_and_ps(_mm256_cmp_ps(gridZ, lowLimit, _CMP_GE_OQ), _mm256_cmp_ps(gridZ, highLimit, _CMP_LE_OQ)));
+
+			__m256i cellI = _mm256_cvttps_epi32(_mm256_min_ps(_mm256_max_ps(gridX, zero), lastCell));
+			__m256i cellJ = _mm256_cvttps_epi32(_mm256_min_ps(_mm256_max_ps(gridZ, zero), lastCell));
+			__m256 cellX = _mm256_min_ps(_mm256_max_ps(_mm256_sub_ps(gridX, _mm256_cvtepi32_ps(cellI)), zero), one);
+			__m256 cellZ = _mm256_min_ps(_mm256_max_ps(_mm256_sub_ps(gridZ, _mm256_cvtepi32_ps(cellJ)), zero), one);
+
+			__m256i index0 = _mm256_add_epi32(_mm256_mullo_epi32(cellI, rowLength), cellJ);
+			__m256i index1 = _mm256_add_epi32(index0, rowLength);
+			__m256i index2 = _mm256_add_epi32(index0, next);
+			__m256 upper = _mm256_cmp_ps(_mm256_add_ps(cellX, cellZ), one, _CMP_GT_OQ);
+			__m256i upperMask = _mm256_castps_si256(upper);
+			__m256i corners[3] = { _mm256_blendv_epi8(index0, index1, upperMask), _mm256_blendv_epi8(index1, _mm256_add_epi32(index1, next), upperMask), index2 };
+			__m256 weights[3] = {
+				_mm256_blendv_ps(_mm256_sub_ps(_mm256_sub_ps(one, cellX), cellZ), _mm256_sub_ps(one, cellZ), upper),
+				_mm256_blendv_ps(cellX, _mm256_sub_ps(_mm256_add_ps(cellX, cellZ), one), upper),
+				_mm256_blendv_ps(cellZ, _mm256_sub_ps(one, cellX), upper) };
+
+			__m256 height = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(weights[0], _mm256_i32gather_ps(grid.heights, corners[0], 4)),
+				_mm256_mul_ps(weights[1], _mm256_i32gather_ps(grid.heights, corners[1], 4))),
+				_mm256_mul_ps(weights[2], _mm256_i32gather_ps(grid.heights, corners[2], 4)));
+			_mm256_storeu_ps(heights + i, height);
+			int insideBits = _mm256_movemask_ps(inside);
+			for (int lane = 0; lane < 8; ++lane)
+			{
+				hits[i + lane] = static_cast<uint8_t>((insideBits >> lane) & 1);
+			}
+			if (!normals) continue;
+
+			__m256i normalOffsets[3] = { _mm256_mullo_epi32(corners[0], three), _mm256_mullo_epi32(corners[1], three), _mm256_mullo_epi32(corners[2], three) };
+			__m256 normal[3];
+			for (int axis = 0; axis < 3; ++axis)
+			{
+				const float* component = grid.normals + axis;
+				normal[axis] = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(weights[0], _mm256_i32gather_ps(component, normalOffsets[0], 4)),
+					_mm256_mul_ps(weights[1], _mm256_i32gather_ps(component, normalOffsets[1], 4))),
+					_mm256_mul_ps(weights[2], _mm256_i32gather_ps(component, normalOffsets[2], 4)));
+			}
+			__m256 lengthSquared = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(normal[0], normal[0]), _mm256_mul_ps(normal[1], normal[1])), _mm256_mul_ps(normal[2], normal[2]));
+			__m256 inverseLength = _mm256_div_ps(one, _mm256_sqrt_ps(lengthSquared));
+			alignas(32) float normalLanes[3][8];
+			for (int axis = 0; axis < 3; ++axis)
+			{
+				_mm256_store_ps(normalLanes[axis], _mm256_mul_ps(normal[axis], inverseLength));
+			}
+			for (int lane = 0; lane < 8; ++lane)
+			{
+				for (int axis = 0; axis < 3; ++axis)
+				{
+					normals[(i + lane) * 3 + axis] = normalLanes[axis][lane];
+				}
+			}
+		}
+		GridTrianglesScalar(x, z, i, count, grid, heights, normals, hits);
+	}
+
+	/*
+	 * CPU feature detection
+	 */
+	void ReadCpuid(int leaf, int subLeaf, unsigned int registers[4])
+	{
+#ifdef _MSC_VER
+		int values[4];
+		__cpuidex(values, leaf, subLeaf);
+		for (int i = 0; i < 4; ++i) registers[i] = static_cast<unsigned int>(values[i]);
+#else
+		__cpuid_count(leaf, subLeaf, registers[0], registers[1], registers[2], registers[3]);
+#endif
+	}
+
+	// AVX registers are only usable when the OS saves them on context switches
+	bool IsAvxStateEnabled()
+	{
+#ifdef _MSC_VER
+		unsigned long long enabledState = _xgetbv(0);
+#else
+		unsigned int eax, edx;
+		__asm__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+		unsigned long long enabledState = (static_cast<unsigned long long>(edx) << 32) | eax;
+#endif
+		return (enabledState & 0x6) == 0x6;
+	}
+
+	PointKernelSet DetectKernelSet()
+	{
+		unsigned int registers[4];
+		ReadCpuid(0, 0, registers);
+		unsigned int highestLeaf = registers[0];
+		if (highestLeaf < 1) return PointKernelSet::SCALAR;
+
+		ReadCpuid(1, 0, registers);
+		bool hasSse41 = (registers[2] & (1u << 19)) != 0;
+		bool hasOsxsave = (registers[2] & (1u << 27)) != 0;
+		bool hasAvx = (registers[2] & (1u << 28)) != 0;
+		if (highestLeaf >= 7 && hasOsxsave && hasAvx && IsAvxStateEnabled())
+		{
+			ReadCpuid(7, 0, registers);
+			if (registers[1] & (1u << 5)) return PointKernelSet::AVX2;
+		}
+		return hasSse41 ? PointKernelSet::SSE41 : PointKernelSet::SCALAR;
+	}
+#else
+	PointKernelSet DetectKernelSet()
+	{
+		return PointKernelSet::SCALAR;
+	}
+#endif
+
+	PointKernelSet GetSupportedKernelSet()
+	{
+		static const PointKernelSet supportedKernelSet = DetectKernelSet();
+		return supportedKernelSet;
+	}
+
+	std::atomic<PointKernelSet> gActiveKernelSet{ GetSupportedKernelSet() };
+}
+
+PointBoundsXZ PointKernels::ComputeBounds(const float* x, const float* z, size_t count)
+{
+	PointBoundsXZ bounds;
+	if (count == 0) return bounds;
+
+	bounds = { x[0], x[0], z[0], z[0] };
+	switch (GetKernelSet())
+	{
+#ifdef POINTKERNELS_X86
+	case PointKernelSet::AVX2: BoundsAVX2(x, z, count, bounds); break;
+	case PointKernelSet::SSE41: BoundsSSE41(x, z, count, bounds); break;
+#endif
+	default: BoundsScalar(x, z, 0, count, bounds); break;
+	}
+	return bounds;
+}
+
+void PointKernels::Translate(float* x, float* z, size_t count, float offsetX, float offsetZ)
+{
+	switch (GetKernelSet())
+	{
+#ifdef POINTKERNELS_X86
+	case PointKernelSet::AVX2: TranslateAVX2(x, z, count, offsetX, offsetZ); break;
+	case PointKernelSet::SSE41: TranslateSSE41(x, z, count, offsetX, offsetZ); break;
+#endif
+	default: TranslateScalar(x, z, 0, count, offsetX, offsetZ); break;
+	}
+}
+
+void PointKernels::ComputeCellIndices(const float* x, const float* z, size_t count, float originX, float originZ, float inverseCellSize, int cellsX, int cellsZ, uint32_t* cells)
+{
+	switch (GetKernelSet())
+	{
+#ifdef POINTKERNELS_X86
+	case PointKernelSet::AVX2: CellIndicesAVX2(x, z, count, originX, originZ, inverseCellSize, cellsX, cellsZ, cells); break;
+	case PointKernelSet::SSE41: CellIndicesSSE41(x, z, count, originX, originZ, inverseCellSize, cellsX, cellsZ, cells); break;
+#endif
+	default: CellIndicesScalar(x, z, 0, count, originX, originZ, inverseCellSize, cellsX, cellsZ, cells); break;
+	}
+}
+
+void PointKernels::SampleGridTriangles(const float* x, const float* z, size_t count, const GridSampleLayout& grid, float* heights, float* normals, uint8_t* hits)
+{
+	if (grid.resolution < 2) return;
+
+	switch (GetKernelSet())
+	{
+#ifdef POINTKERNELS_X86
+	case PointKernelSet::AVX2: GridTrianglesAVX2(x, z, count, grid, heights, normals, hits); break;
+	case PointKernelSet::SSE41: GridTrianglesSSE41(x, z, count, grid, heights, normals, hits); break;
+#endif
+	default: GridTrianglesScalar(x, z, 0, count, grid, heights, normals, hits); break;
+	}
+}
+
+PointKernelSet PointKernels::GetKernelSet()
+{
+	return gActiveKernelSet.load(std::memory_order_relaxed);
+}
+
+const char* PointKernels::GetKernelSetName()
+{
+	switch (GetKernelSet())
+	{
+	case PointKernelSet::AVX2: return "AVX2";
+	case PointKernelSet::SSE41: return "SSE4.1";
+	default: return "scalar";
+	}
+}
+
+void PointKernels::SetKernelSet(PointKernelSet kernelSet)
+{
+	gActiveKernelSet.store(std::min(kernelSet, GetSupportedKernelSet()), std::memory_order_relaxed);
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+/*
+ * Throughput kernels over SoA point coordinates (separate x and z arrays)
+ * Each kernel has a scalar, SSE4.1 and AVX2 version, the fastest one the CPU supports is picked on first use
+ * All versions give bit identical results, so the choice never changes the terrain
+ */
+enum class PointKernelSet
+{
+	SCALAR,
+	SSE41,
+	AVX2
+};
+
+struct PointBoundsXZ
+{
+	float minX{ 0.f };
+	float maxX{ 0.f };
+	float minZ{ 0.f };
+	float maxZ{ 0.f };
+};
+
+// Regular height grid for SampleGridTriangles(), vertex i * resolution + j sits at origin + (i, j) * spacing
+struct GridSampleLayout
+{
+	const float* heights{ nullptr };
+	const float* normals{ nullptr }; // x, y and z per vertex
+	int resolution{ 0 };
+	float originX{ 0.f };
+	float originZ{ 0.f };
+	float inverseSpacingX{ 1.f };
+	float inverseSpacingZ{ 1.f };
+	float edgeTolerance{ 0.f }; // In cells, how far outside the grid a position still counts as a hit
+};
+
+class PointKernels
+{
+public:
+	/*
+	 * Kernels
+	 */
+	static PointBoundsXZ ComputeBounds(const float* x, const float* z, size_t count);
+	static void Translate(float* x, float* z, size_t count, float offsetX, float offsetZ);
+	// cells[i] = cellX * cellsZ + cellZ, points outside the grid go into the nearest edge cell
+	static void ComputeCellIndices(const float* x, const float* z, size_t count, float originX, float originZ, float inverseCellSize, int cellsX, int cellsZ, uint32_t* cells);
+
+	// Height and normal on the grid triangle under every position, cells are split like Mesh::TriangulateGrid does
+	// Positions outside the grid are clamped to its edge and get hits[i] = 0, normals (x, y, z per position) may be null
+	static void SampleGridTriangles(const float* x, const float* z, size_t count, const GridSampleLayout& grid, float* heights, float* normals, uint8_t* hits);
+
+	// Scalar cell coordinate, the same clamp-then-truncate the vector kernels use
+	static int GetCellCoordinate(float value, float origin, float inverseCellSize, int cellCount)
+	{
+		float cell = (value - origin) * inverseCellSize;
+		cell = cell > 0.f ? cell : 0.f;
+		cell = cell < static_cast<float>(cellCount - 1) ? cell : static_cast<float>(cellCount - 1);
+		return static_cast<int>(cell);
+	}
+
+	/*
+	 * Dispatch
+	 */
+	static PointKernelSet GetKernelSet();
+	static const char* GetKernelSetName();
+	// Forces a kernel set, sets the CPU does not support fall back to the best supported one
+	static void SetKernelSet(PointKernelSet kernelSet);
+};
@@ -3,6 +3,34 @@
 #include <fstream>
 #include <iomanip>
 #include <sstream>
+#include <algorithm>
+#include <bit>
+#include <chrono>
+
+#include "LasReader.h"
+#include "MappedFile.h"
+#include "PointCloudCache.h"
+#include "PointCloudConverter.h"
+#include "PointCloudParser.h"
+#include "ThreadPool.h"
+
+namespace
+{
+	// PLY files are written little endian straight from memory
+	static_assert(std::endian::native == std::endian::little, "The PLY exporter writes memory as little endian");
+
+	template <typename Type>
+	void AppendValue(std::vector<char>& Buffer, const Type& Value)
+	{
+		const char* Bytes = reinterpret_cast<const char*>(&Value);
+		Buffer.insert(Buffer.end(), Bytes, Bytes + sizeof(Type));
+	}
+
+	uint8_t ColorToByte(float Value)
+	{
+		return static_cast<uint8_t>(std::clamp(Value, 0.f, 1.f) * 255.f + 0.5f);
+	}
+}
 
 ReadWriteFiles::ReadWriteFiles()
 {
@@ -20,7 +48,7 @@ void ReadWriteFiles::WriteToFile(std::string Filepath, std::vector<Vertex>& Vert
 		MyFile << std::fixed << std::setprecision(4);
 		std::cout << "File has been opened correctly\n";
 		MyFile << "Amount of Vertices: " << VertexVector.size() << "\n";
-		for (Vertex Vert : VertexVector)
+		for (const Vertex& Vert : VertexVector)
 		{
 			MyFile << "x: " << Vert.mPosition.x << ", ";
 			MyFile << "y: " << Vert.mPosition.y << ", ";
@@ -40,6 +68,68 @@ void ReadWriteFiles::WriteToFile(std::string Filepath, std::vector<Vertex>& Vert
 	}
 }
 
+bool ReadWriteFiles::WriteToPlyFile(std::string Filepath, const std::vector<Vertex>& VertexVector, const std::vector<Index>& IndexVector)
+{
+	std::ofstream MyFile(Filepath, std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!MyFile.is_open())
+	{
+		std::cerr << "Error opening files." << std::endl;
+		return false;
+	}
+
+	auto startTime = std::chrono::high_resolution_clock::now();
+	const size_t FaceCount = IndexVector.size() / 3;
+	MyFile << "ply\n"
+		<< "format binary_little_endian 1.0\n"
+		<< "element vertex " << VertexVector.size() << "\n"
+		<< "property float x\nproperty float y\nproperty float z\n"
+		<< "property float nx\nproperty float ny\nproperty float nz\n"
+		<< "property uchar red\nproperty uchar green\nproperty uchar blue\n"
+		<< "element face " << FaceCount << "\n"
+		<< "property list uchar uint vertex_indices\n"
+		<< "end_header\n";
+
+	// Records are packed into a large buffer that is written in one call whenever it fills up
+	const size_t FlushSize = 4 << 20;
+	std::vector<char> Buffer;
+	Buffer.reserve(FlushSize + 64);
+	auto FlushIfFull = [&]()
+		{
+			if (Buffer.size() >= FlushSize)
+			{
+				MyFile.write(Buffer.data(), static_cast<std::streamsize>(Buffer.size()));
+				Buffer.clear();
+			}
+		};
+
+	for (const Vertex& Vert : VertexVector)
+	{
+		AppendValue(Buffer, Vert.mPosition);
+		AppendValue(Buffer, Vert.mNormal);
+		AppendValue(Buffer, ColorToByte(Vert.mColor.r));
+		AppendValue(Buffer, ColorToByte(Vert.mColor.g));
+		AppendValue(Buffer, ColorToByte(Vert.mColor.b));
+		FlushIfFull();
+	}
+
+	for (size_t Face = 0; Face < FaceCount; ++Face)
+	{
+		AppendValue(Buffer, uint8_t(3));
+		Buffer.insert(Buffer.end(), reinterpret_cast<const char*>(&IndexVector[Face * 3]), reinterpret_cast<const char*>(&IndexVector[Face * 3 + 3]));
+		FlushIfFull();
+	}
+	MyFile.write(Buffer.data(), static_cast<std::streamsize>(Buffer.size()));
+
+	bool bIsWritten = MyFile.good();
+	double FileSizeMB = static_cast<double>(MyFile.tellp()) / (1024.0 * 1024.0);
+	MyFile.close();
+
+	std::chrono::duration<double> elapsedTime = std::chrono::high_resolution_clock::now() - startTime;
+	std::cout << "Exported " << VertexVector.size() << " vertices and " << FaceCount << " triangles to " << Filepath << ", "
+		<< FileSizeMB << " MB in " << elapsedTime.count() << " s (" << FileSizeMB / std::max(elapsedTime.count(), 1e-9) << " MB/s)\n";
+	return bIsWritten;
+}
+
 void ReadWriteFiles::AppendToFile(std::string Filepath)
 {
 	/*Appending into file*/
@@ -79,128 +169,473 @@ void ReadWriteFiles::ReadFromFile(std::string FileToRead)
 
 void ReadWriteFiles::ReadFromFileWriteIntoNewFile(std::string FileToRead, std::string NewDataFile)
 {
-	std::fstream MyFileRead;
-	std::fstream MyFileWrite;
-	MyFileRead.open(FileToRead, std::ios::in);
-	MyFileWrite.open(NewDataFile, std::ios::out);
+	// Runs the same reader -> clean/parse -> writer pipeline as the offline PointCloudConverter tool
+	PointCloudConvertSettings Settings;
+	Settings.inputPath = FileToRead;
+	Settings.outputPath = NewDataFile;
+	if (PointCloudConverter::Convert(Settings))
+	{
+		std::cout << "Commas removed successfully." << std::endl;
+	}
+}
 
-	if (MyFileRead.is_open() && MyFileWrite.is_open())
+void ReadWriteFiles::FromDataToVertexVector(std::string DataFileToVertexVector, std::vector<Vertex>& VerticesVector, bool bIsUsingColors, unsigned int ThreadCount)
+{
+	// Mapping the whole file into memory and parsing it in place, no per line allocations
+	MappedFile MyFile(DataFileToVertexVector);
+	if (MyFile.IsOpen())
 	{
-		int currentLine {0};
-		MyFileWrite << std::fixed << std::setprecision(4);
-		std::cout << "Reading file: " << FileToRead << std::endl;
-		std::cout << "Starting to write into new file: " << NewDataFile << std::endl;
-		std::string Line;
-		// Skip the first line
-		std::getline(MyFileRead, Line);
-		while (std::getline(MyFileRead, Line))
-		{
-			currentLine ++;
-			if (currentLine % 2 == 0) continue;
-			RemovingUnwantedChars(Line);
-
-			// Tokenize the line based on spaces
-			std::istringstream iss(Line);
-			std::vector<float> floats;
-			float Number;
-			while (iss >> Number)
+		std::cout << "File has been opened correctly\n";
+		auto startTime = std::chrono::high_resolution_clock::now();
+
+		size_t PreviousSize = VerticesVector.size();
+		ThreadCount = ThreadPool::ResolveThreadCount(ThreadCount);
+		if (ThreadCount > 1)
+		{
+			std::cout << "Parsing with " << ThreadCount << " threads\n";
+			ParsePointCloudTextParallel(MyFile.GetData(), MyFile.GetEnd(), VerticesVector, bIsUsingColors, ThreadCount);
+		}
+		else
+		{
+			// Every line is one point, so the line count is used to reserve the vector up front
+			VerticesVector.reserve(VerticesVector.size() + PointCloudParser::CountLines(MyFile.GetData(), MyFile.GetEnd()));
+			ParsePointCloudText(MyFile.GetData(), MyFile.GetEnd(), VerticesVector, bIsUsingColors);
+		}
+
+		std::chrono::duration<double> elapsedTime = std::chrono::high_resolution_clock::now() - startTime;
+		double FileSizeMB = MyFile.GetSize() / (1024.0 * 1024.0);
+		std::cout << "Finished reading lines" << "\n";
+		std::cout << "Amount of Vertexes added to the vector: " << VerticesVector.size() - PreviousSize << "\n";
+		std::cout << "Parsed " << FileSizeMB << " MB in " << elapsedTime.count() << " s (" << FileSizeMB / std::max(elapsedTime.count(), 1e-9) << " MB/s)\n";
+	}
+	else
+	{
+		std::cerr << "Error opening files." << std::endl;
+	}
+}
+
+void ReadWriteFiles::FromCachedDataToVertexVector(std::string DataFileToVertexVector, std::vector<Vertex>& VerticesVector, bool bIsUsingColors, unsigned int ThreadCount)
+{
+	uint64_t SourceSize = 0;
+	uint64_t SourceHash = 0;
+	if (!PointCloudCache::HashSourceFile(DataFileToVertexVector, SourceSize, SourceHash))
+	{
+		std::cerr << "Error opening files." << std::endl;
+		return;
+	}
+
+	// Using the binary cache when it was written from this exact source file
+	std::string CacheFile = PointCloudCache::GetCachePath(DataFileToVertexVector);
+	PointCloudCacheView Cache;
+	bool bIsCacheUsable = Cache.Open(CacheFile) && Cache.MatchesSource(SourceSize, SourceHash) && (Cache.HasColors() || !bIsUsingColors);
+
+	// A stale cache stays mapped otherwise, and a mapped file can not be replaced on Windows
+	Cache.Close();
+	if (bIsCacheUsable)
+	{
+		FromBinaryDataToVertexVector(CacheFile, VerticesVector, bIsUsingColors);
+		return;
+	}
+
+	// No usable cache, parsing the text file and writing the cache for the next run
+	size_t PreviousSize = VerticesVector.size();
+	FromDataToVertexVector(DataFileToVertexVector, VerticesVector, bIsUsingColors, ThreadCount);
+	if (WritePointCloudCache(CacheFile, VerticesVector.data() + PreviousSize, VerticesVector.size() - PreviousSize, bIsUsingColors, SourceSize, SourceHash))
+	{
+		std::cout << "Point cloud cache written to: " << CacheFile << "\n";
+	}
+}
+
+bool ReadWriteFiles::FromBinaryDataToVertexVector(std::string BinaryFile, std::vector<Vertex>& VerticesVector, bool bIsUsingColors)
+{
+	PointCloudCacheView Cache;
+	if (!Cache.Open(BinaryFile) || (bIsUsingColors && !Cache.HasColors()))
+	{
+		std::cerr << "Error opening binary point file: " << BinaryFile << std::endl;
+		return false;
+	}
+
+	auto startTime = std::chrono::high_resolution_clock::now();
+	const float* Positions = Cache.GetPositions();
+	const float* Colors = Cache.GetColors();
+	size_t PointCount = static_cast<size_t>(Cache.GetPointCount());
+
+	VerticesVector.reserve(VerticesVector.size() + PointCount);
+	for (size_t i = 0; i < PointCount; ++i)
+	{
+		const float* Position = Positions + i * 3;
+		if (bIsUsingColors)
+		{
+			const float* Color = Colors + i * 3;
+			VerticesVector.emplace_back(Vertex{ Position[0], Position[1], Position[2], Color[0], Color[1], Color[2] });
+		}
+		else
+		{
+			VerticesVector.emplace_back(Vertex{ Position[0], Position[1], Position[2] });
+		}
+	}
+
+	std::chrono::duration<double> elapsedTime = std::chrono::high_resolution_clock::now() - startTime;
+	std::cout << "Loaded " << PointCount << " points from " << BinaryFile << " in " << elapsedTime.count() << " s\n";
+	return true;
+}
+
+bool ReadWriteFiles::FromLasDataToVertexVector(std::string LasFile, std::vector<Vertex>& VerticesVector, bool bIsUsingColors, unsigned int ThreadCount)
+{
+	LasReader Reader;
+	if (!Reader.Open(LasFile)) return false;
+
+	auto startTime = std::chrono::high_resolution_clock::now();
+	const uint64_t PointCount = Reader.GetPointCount();
+	const size_t PreviousSize = VerticesVector.size();
+	VerticesVector.resize(PreviousSize + PointCount, Vertex(0.f, 0.f, 0.f, 0.f, 0.f, 0.f));
+
+	// Records have a fixed size, so the points are split into batches that are decoded straight into their place in the vector
+	const uint64_t BatchSize = 1 << 16;
+	const uint64_t BatchCount = (PointCount + BatchSize - 1) / BatchSize;
+	auto DecodeBatch = [&](uint64_t Batch)
+		{
+			uint64_t FirstPoint = Batch * BatchSize;
+			uint64_t BatchPoints = std::min(BatchSize, PointCount - FirstPoint);
+			std::vector<float> Positions(BatchPoints * 3);
+			std::vector<float> Colors(bIsUsingColors ? BatchPoints * 3 : 0);
+			Reader.DecodePoints(FirstPoint, BatchPoints, Positions.data(), bIsUsingColors ? Colors.data() : nullptr);
+
+			for (uint64_t i = 0; i < BatchPoints; ++i)
 			{
-				floats.push_back(Number);
+				const float* Position = &Positions[i * 3];
+				Vertex& Target = VerticesVector[PreviousSize + FirstPoint + i];
+				if (bIsUsingColors)
+				{
+					const float* Color = &Colors[i * 3];
+					Target = Vertex{ Position[0], Position[1], Position[2], Color[0], Color[1], Color[2] };
+				}
+				else
+				{
+					Target = Vertex{ Position[0], Position[1], Position[2] };
+				}
 			}
+		};
 
-			// Write the code to floats to the output file
-			for (float Number : floats)
+	ThreadCount = ThreadPool::ResolveThreadCount(ThreadCount);
+	if (ThreadCount > 1 && BatchCount > 1)
+	{
+		ThreadPool Pool(ThreadCount);
+		std::vector<std::future<void>> BatchResults;
+		BatchResults.reserve(BatchCount);
+		for (uint64_t Batch = 0; Batch < BatchCount; ++Batch)
+		{
+			BatchResults.emplace_back(Pool.Submit([&, Batch]() { DecodeBatch(Batch); }));
+		}
+		for (auto& Result : BatchResults)
+		{
+			Result.get();
+		}
+	}
+	else
+	{
+		for (uint64_t Batch = 0; Batch < BatchCount; ++Batch)
+		{
+			DecodeBatch(Batch);
+		}
+	}
+
+	std::chrono::duration<double> elapsedTime = std::chrono::high_resolution_clock::now() - startTime;
+	double PointDataMB = Reader.GetPointDataSize() / (1024.0 * 1024.0);
+	std::cout << "Amount of Vertexes added to the vector: " << PointCount << "\n";
+	std::cout << "Decoded " << PointDataMB << " MB of LAS records in " << elapsedTime.count() << " s (" << PointDataMB / std::max(elapsedTime.count(), 1e-9) << " MB/s)\n";
+	return true;
+}
+
+bool ReadWriteFiles::WritePointCloudCache(std::string CacheFile, const Vertex* Vertices, size_t VertexCount, bool bIsUsingColors, uint64_t SourceSize, uint64_t SourceHash)
+{
+	PointCloudCacheWriter Writer;
+	if (!Writer.Open(CacheFile, bIsUsingColors, SourceSize, SourceHash)) return false;
+
+	for (size_t i = 0; i < VertexCount; ++i)
+	{
+		Writer.AddPoints(&Vertices[i].mPosition.x, &Vertices[i].mColor.x, 1);
+	}
+	return Writer.Finish();
+}
+
+bool ReadWriteFiles::WritePointCloudCacheFromText(std::string DataFile, bool bIsUsingColors)
+{
+	uint64_t SourceSize = 0;
+	uint64_t SourceHash = 0;
+	if (!PointCloudCache::HashSourceFile(DataFile, SourceSize, SourceHash)) return false;
+
+	std::string CacheFile = PointCloudCache::GetCachePath(DataFile);
+	PointCloudCacheView Cache;
+	if (Cache.Open(CacheFile) && Cache.MatchesSource(SourceSize, SourceHash) && (Cache.HasColors() || !bIsUsingColors)) return true;
+	Cache.Close();
+
+	// Streaming the text straight into the cache, no vertex vector is kept in memory
+	MappedFile MyFile(DataFile);
+	PointCloudCacheWriter Writer;
+	if (!MyFile.IsOpen() || !Writer.Open(CacheFile, bIsUsingColors, SourceSize, SourceHash)) return false;
+
+	const int ValuesPerPoint = bIsUsingColors ? 6 : 3;
+	float Values[6];
+	const char* Cursor = MyFile.GetData();
+	while (Cursor < MyFile.GetEnd())
+	{
+		if (PointCloudParser::ParseLine(Cursor, MyFile.GetEnd(), Values, ValuesPerPoint) < ValuesPerPoint) continue;
+
+		float Position[3]{ Values[0], Values[2], Values[1] };
+		Writer.AddPoints(Position, Values + 3, 1);
+	}
+
+	if (!Writer.Finish()) return false;
+	std::cout << "Point cloud cache written to: " << CacheFile << "\n";
+	return true;
+}
+
+bool ReadWriteFiles::OpenPointCloudCache(std::string DataFile, bool bIsUsingColors, PointCloudCacheView& Cache)
+{
+	// A .pcbin file is opened as it is, a text file only uses its cache when the cache was written from this exact source
+	if (PointCloudCache::IsBinaryPointFile(DataFile))
+	{
+		return Cache.Open(DataFile) && (Cache.HasColors() || !bIsUsingColors);
+	}
+
+	uint64_t SourceSize = 0;
+	uint64_t SourceHash = 0;
+	if (PointCloudCache::HashSourceFile(DataFile, SourceSize, SourceHash) && Cache.Open(PointCloudCache::GetCachePath(DataFile)) &&
+		Cache.MatchesSource(SourceSize, SourceHash) && (Cache.HasColors() || !bIsUsingColors))
+	{
+		return true;
+	}
+
+	// A stale cache is not kept mapped, so it can be rewritten while the caller falls back to the text
+	Cache.Close();
+	return false;
+}
+
+bool ReadWriteFiles::SamplePointsFromFile(std::string DataFile, std::vector<Vertex>& VerticesVector, bool bIsUsingColors, size_t SampleCount)
+{
+	// Picks about SampleCount points spread evenly over the file without reading the rest of it
+	float Position[3];
+	float Color[3]{ 1.f, 1.f, 1.f };
+	auto AddSample = [&]()
+		{
+			if (bIsUsingColors)
 			{
-				MyFileWrite << Number << " ";
+				VerticesVector.emplace_back(Vertex{ Position[0], Position[1], Position[2], Color[0], Color[1], Color[2] });
 			}
-			MyFileWrite << std::endl;
+			else
+			{
+				VerticesVector.emplace_back(Vertex{ Position[0], Position[1], Position[2] });
+			}
+		};
+
+	if (LasReader::IsLasFile(DataFile))
+	{
+		LasReader Reader;
+		if (!Reader.Open(DataFile)) return false;
+		uint64_t PointCount = Reader.GetPointCount();
+		uint64_t Samples = std::min<uint64_t>(SampleCount, PointCount);
+		for (uint64_t i = 0; i < Samples; ++i)
+		{
+			Reader.DecodePoints(i * PointCount / Samples, 1, Position, bIsUsingColors ? Color : nullptr);
+			AddSample();
 		}
-		MyFileRead.close();
-		MyFileWrite.close();
-		std::cout << "Commas removed successfully." << std::endl;
+		return true;
 	}
-	else
+
+	PointCloudCacheView Cache;
+	if (OpenPointCloudCache(DataFile, bIsUsingColors, Cache))
+	{
+		uint64_t PointCount = Cache.GetPointCount();
+		uint64_t Samples = std::min<uint64_t>(SampleCount, PointCount);
+		for (uint64_t i = 0; i < Samples; ++i)
+		{
+			uint64_t Point = i * PointCount / Samples;
+			std::copy_n(Cache.GetPositions() + Point * 3, 3, Position);
+			if (bIsUsingColors) std::copy_n(Cache.GetColors() + Point * 3, 3, Color);
+			AddSample();
+		}
+		return true;
+	}
+
+	MappedFile MyFile(DataFile);
+	if (PointCloudCache::IsBinaryPointFile(DataFile) || !MyFile.IsOpen())
 	{
 		std::cerr << "Error opening files." << std::endl;
+		return false;
+	}
+
+	// Jumping to evenly spaced byte offsets and parsing the first full line after each of them
+	const int ValuesPerPoint = bIsUsingColors ? 6 : 3;
+	float Values[6];
+	const char* PreviousLine = nullptr;
+	for (size_t i = 0; i < SampleCount; ++i)
+	{
+		const char* Cursor = MyFile.GetData() + MyFile.GetSize() * i / SampleCount;
+		if (i > 0)
+		{
+			Cursor = std::find(Cursor, MyFile.GetEnd(), '\n');
+			if (Cursor != MyFile.GetEnd()) Cursor++;
+		}
+		if (Cursor >= MyFile.GetEnd() || Cursor == PreviousLine) continue;
+		PreviousLine = Cursor;
+
+		if (PointCloudParser::ParseLine(Cursor, MyFile.GetEnd(), Values, ValuesPerPoint) < ValuesPerPoint) continue;
+		Position[0] = Values[0];
+		Position[1] = Values[2];
+		Position[2] = Values[1];
+		if (bIsUsingColors) std::copy_n(Values + 3, 3, Color);
+		AddSample();
 	}
+	return true;
 }
 
-void ReadWriteFiles::FromDataToVertexVector(std::string DataFileToVertexVector, std::vector<Vertex>& VerticesVector, bool bIsUsingColors)
+bool ReadWriteFiles::ForEachPointInFile(std::string DataFile, bool bIsUsingColors, const std::function<void(const Vertex&)>& Visitor)
 {
-	std::fstream MyFile;
-	MyFile.open(DataFileToVertexVector, std::ios::in); // Read mode
-	if (MyFile.is_open())
+	if (LasReader::IsLasFile(DataFile))
 	{
-		int currentLine {0};
-		std::cout << "File has been opened correctly\n";
-		std::string Line;
-		while (std::getline(MyFile, Line))
+		LasReader Reader;
+		if (!Reader.Open(DataFile)) return false;
+
+		// Decoding in batches keeps the memory use fixed no matter how many points the file has
+		const uint64_t BatchSize = 1 << 16;
+		std::vector<float> Positions(BatchSize * 3);
+		std::vector<float> Colors(BatchSize * 3);
+		for (uint64_t FirstPoint = 0; FirstPoint < Reader.GetPointCount(); FirstPoint += BatchSize)
 		{
-			std::istringstream iss(Line);
-			std::vector<float> floats;
-			float Number;
-			while (iss >> Number)
+			uint64_t BatchPoints = std::min(BatchSize, Reader.GetPointCount() - FirstPoint);
+			Reader.DecodePoints(FirstPoint, BatchPoints, Positions.data(), bIsUsingColors ? Colors.data() : nullptr);
+			for (uint64_t i = 0; i < BatchPoints; ++i)
 			{
-				currentLine ++;
-				if (currentLine % 500000 == 0)
+				const float* Position = &Positions[i * 3];
+				if (bIsUsingColors)
 				{
-					std::cout << "Current line: " << currentLine << "\n";
+					const float* Color = &Colors[i * 3];
+					Visitor(Vertex{ Position[0], Position[1], Position[2], Color[0], Color[1], Color[2] });
+				}
+				else
+				{
+					Visitor(Vertex{ Position[0], Position[1], Position[2] });
 				}
-				floats.push_back(Number);
 			}
+		}
+		return true;
+	}
 
+	// Reading binary point files directly, and text files from their binary cache when there is one for this source
+	PointCloudCacheView Cache;
+	bool bIsBinary = PointCloudCache::IsBinaryPointFile(DataFile);
+	if (OpenPointCloudCache(DataFile, bIsUsingColors, Cache))
+	{
+		const float* Positions = Cache.GetPositions();
+		const float* Colors = Cache.GetColors();
+		for (uint64_t i = 0; i < Cache.GetPointCount(); ++i)
+		{
+			const float* Position = Positions + i * 3;
 			if (bIsUsingColors)
 			{
-				float TempX = floats[0];
-				float TempY = floats[1];
-				float TempZ = floats[2];
-				float TempR = floats[3];
-				float TempG = floats[4];
-				float TempB = floats[5];
-				VerticesVector.emplace_back(Vertex{ TempX, TempZ, TempY, TempR, TempG, TempB });
+				const float* Color = Colors + i * 3;
+				Visitor(Vertex{ Position[0], Position[1], Position[2], Color[0], Color[1], Color[2] });
 			}
-
 			else
 			{
-				float TempX = floats[0];
-				float TempY = floats[1];
-				float TempZ = floats[2];
-				VerticesVector.emplace_back(Vertex{ TempX, TempZ, TempY });
+				Visitor(Vertex{ Position[0], Position[1], Position[2] });
 			}
-
-			//float TempU = floats[6];
-			//float TempV = floats[7];
-			//VerticesVector.emplace_back(Vertex{ TempX, TempY, TempZ, TempR, TempG, TempB, TempU, TempV }*/)
-			//float TempR = floats[3];
-			//float TempG = floats[4];
-			//float TempB = floats[5];
-			//float TempN1 = floats[6];
-			//float TempN2 = floats[7];
-			//float TempN3 = floats[8];
-			//VerticesVector.emplace_back(Vertex{ glm::vec3{TempX, TempY, TempZ}, glm::vec3{TempR, TempG, TempB}, glm::vec3{TempN1, TempN2,TempN3}});
 		}
-		std::cout << "Finished reading lines" << "\n";
-		std::cout << "Amount of Vertexes added to the vector: " << "\n";
-		MyFile.close();
+		return true;
 	}
-	else
+
+	MappedFile MyFile(DataFile);
+	if (bIsBinary || !MyFile.IsOpen())
 	{
 		std::cerr << "Error opening files." << std::endl;
+		return false;
+	}
+
+	const int ValuesPerPoint = bIsUsingColors ? 6 : 3;
+	float Values[6];
+	const char* Cursor = MyFile.GetData();
+	while (Cursor < MyFile.GetEnd())
+	{
+		if (PointCloudParser::ParseLine(Cursor, MyFile.GetEnd(), Values, ValuesPerPoint) < ValuesPerPoint) continue;
+
+		if (bIsUsingColors)
+		{
+			Visitor(Vertex{ Values[0], Values[2], Values[1], Values[3], Values[4], Values[5] });
+		}
+		else
+		{
+			Visitor(Vertex{ Values[0], Values[2], Values[1] });
+		}
+	}
+	return true;
+}
+
+void ReadWriteFiles::ParsePointCloudText(const char* Begin, const char* End, std::vector<Vertex>& VerticesVector, bool bIsUsingColors)
+{
+	// Each line is "x y z" or "x y z r g b", y and z are swapped since the data is z-up
+	const int ValuesPerPoint = bIsUsingColors ? 6 : 3;
+	float Values[6];
+	const char* Cursor = Begin;
+	while (Cursor < End)
+	{
+		// Lines without enough numbers (empty lines, headers) are skipped
+		if (PointCloudParser::ParseLine(Cursor, End, Values, ValuesPerPoint) < ValuesPerPoint) continue;
+
+		if (bIsUsingColors)
+		{
+			VerticesVector.emplace_back(Vertex{ Values[0], Values[2], Values[1], Values[3], Values[4], Values[5] });
+		}
+		else
+		{
+			VerticesVector.emplace_back(Vertex{ Values[0], Values[2], Values[1] });
+		}
+	}
+}
+
+void ReadWriteFiles::ParsePointCloudTextParallel(const char* Begin, const char* End, std::vector<Vertex>& VerticesVector, bool bIsUsingColors, unsigned int ThreadCount)
+{
+	// A few chunks per thread keeps the threads busy when some chunks parse slower than others
+	std::vector<const char*> ChunkBoundaries = PointCloudParser::SplitIntoLineChunks(Begin, End, ThreadCount * 4);
+	size_t ChunkCount = ChunkBoundaries.size() - 1;
+	std::vector<std::vector<Vertex>> ChunkVertices(ChunkCount);
+
+	{
+		ThreadPool Pool(ThreadCount);
+		std::vector<std::future<void>> ChunkResults;
+		ChunkResults.reserve(ChunkCount);
+		for (size_t i = 0; i < ChunkCount; ++i)
+		{
+			ChunkResults.emplace_back(Pool.Submit([&, i]()
+				{
+					const char* ChunkBegin = ChunkBoundaries[i];
+					const char* ChunkEnd = ChunkBoundaries[i + 1];
+					ChunkVertices[i].reserve(PointCloudParser::CountLines(ChunkBegin, ChunkEnd));
+					ParsePointCloudText(ChunkBegin, ChunkEnd, ChunkVertices[i], bIsUsingColors);
+				}));
+		}
+		for (auto& Result : ChunkResults)
+		{
+			Result.get();
+		}
+	}
+
+	// Appending the chunks in file order gives the same vector as the serial parser
+	size_t TotalVertices = VerticesVector.size();
+	for (const auto& Chunk : ChunkVertices)
+	{
+		TotalVertices += Chunk.size();
+	}
+	VerticesVector.reserve(TotalVertices);
+	for (auto& Chunk : ChunkVertices)
+	{
+		VerticesVector.insert(VerticesVector.end(), Chunk.begin(), Chunk.end());
+		std::vector<Vertex>().swap(Chunk);
 	}
 }
 
 void ReadWriteFiles::RemovingUnwantedChars(std::string& Line)
 {
-	// Symbols and lines to remove:
-	Line.erase(std::remove(Line.begin(), Line.end(), 'x'), Line.end());
-	Line.erase(std::remove(Line.begin(), Line.end(), 'y'), Line.end());
-	Line.erase(std::remove(Line.begin(), Line.end(), 'z'), Line.end());
-	Line.erase(std::remove(Line.begin(), Line.end(), 'r'), Line.end());
-	Line.erase(std::remove(Line.begin(), Line.end(), 'g'), Line.end());
-	Line.erase(std::remove(Line.begin(), Line.end(), 'b'), Line.end());
-	Line.erase(std::remove(Line.begin(), Line.end(), 'u'), Line.end());
-	Line.erase(std::remove(Line.begin(), Line.end(), 'v'), Line.end());
-	Line.erase(std::remove(Line.begin(), Line.end(), ':'), Line.end());
-	Line.erase(std::remove(Line.begin(), Line.end(), ','), Line.end());
-	Line.erase(std::remove(Line.begin(), Line.end(), 'f'), Line.end());
-}
\ No newline at end of file
+	// Symbols and lines to remove: x, y, z, r, g, b, u, v, ':', ',' and 'f'
+	Line.resize(PointCloudParser::RemoveUnwantedChars(Line.data(), Line.size()));
+}
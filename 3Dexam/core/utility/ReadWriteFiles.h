@@ -1,8 +1,13 @@
 #pragma once
+#include <cstdint>
+#include <functional>
 #include <string>
 #include <vector>
 
 #include "graphical/Mesh.h"
+#include "VariableTypes.h"
+
+class PointCloudCacheView;
 
 class ReadWriteFiles
 {
@@ -10,9 +15,20 @@ public:
 
 	ReadWriteFiles();
 	void WriteToFile(std::string Filepath, std::vector<Vertex>& VertexVector);
+	static bool WriteToPlyFile(std::string Filepath, const std::vector<Vertex>& VertexVector, const std::vector<Index>& IndexVector);
 	void AppendToFile(std::string Filepath);
 	void ReadFromFile(std::string FileToRead);
 	static void ReadFromFileWriteIntoNewFile(std::string FileToRead, std::string NewDataFile);
-	static void FromDataToVertexVector(std::string DataFileToVertexVector, std::vector<Vertex>& VerticesVector, bool bIsUsingColors);
+	static void FromDataToVertexVector(std::string DataFileToVertexVector, std::vector<Vertex>& VerticesVector, bool bIsUsingColors, unsigned int ThreadCount = 1);
+	static void FromCachedDataToVertexVector(std::string DataFileToVertexVector, std::vector<Vertex>& VerticesVector, bool bIsUsingColors, unsigned int ThreadCount = 1);
+	static bool FromBinaryDataToVertexVector(std::string BinaryFile, std::vector<Vertex>& VerticesVector, bool bIsUsingColors);
+	static bool FromLasDataToVertexVector(std::string LasFile, std::vector<Vertex>& VerticesVector, bool bIsUsingColors, unsigned int ThreadCount = 1);
+	static bool WritePointCloudCache(std::string CacheFile, const Vertex* Vertices, size_t VertexCount, bool bIsUsingColors, uint64_t SourceSize, uint64_t SourceHash);
+	static bool WritePointCloudCacheFromText(std::string DataFile, bool bIsUsingColors);
+	static bool OpenPointCloudCache(std::string DataFile, bool bIsUsingColors, PointCloudCacheView& Cache);
+	static bool SamplePointsFromFile(std::string DataFile, std::vector<Vertex>& VerticesVector, bool bIsUsingColors, size_t SampleCount);
+	static bool ForEachPointInFile(std::string DataFile, bool bIsUsingColors, const std::function<void(const Vertex&)>& Visitor);
+	static void ParsePointCloudText(const char* Begin, const char* End, std::vector<Vertex>& VerticesVector, bool bIsUsingColors);
+	static void ParsePointCloudTextParallel(const char* Begin, const char* End, std::vector<Vertex>& VerticesVector, bool bIsUsingColors, unsigned int ThreadCount);
 	static void RemovingUnwantedChars(std::string& Line);
 };
@@ -0,0 +1,79 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <glm/glm.hpp>
+
+/*
+ * Optional statistics on top of the mean height and color, the mean is always tracked
+ */
+enum SampleStatistics : uint32_t
+{
+	SAMPLEMINMAX = 1 << 0,
+	SAMPLEVARIANCE = 1 << 1
+};
+
+/*
+ * Running reduction of the points that fall into one terrain sample, nothing is stored per point
+ * Heights and colors are summed in the order they are added, the variance uses Welford's update
+ */
+class SampleAccumulator
+{
+public:
+	explicit SampleAccumulator(uint32_t statistics = 0) : mStatistics(statistics) {}
+
+	void Reset()
+	{
+		mHeightSum = 0.f;
+		mColorSum = glm::vec3(0.f);
+		mCount = 0;
+		mMinHeight = std::numeric_limits<float>::max();
+		mMaxHeight = std::numeric_limits<float>::lowest();
+		mVarianceMean = 0.f;
+		mVarianceSum = 0.f;
+	}
+
+	void AddPoint(float height, const glm::vec3& color)
+	{
+		mHeightSum += height;
+		mColorSum += color;
+		mCount++;
+
+		if (mStatistics & SAMPLEMINMAX)
+		{
+			mMinHeight = std::min(mMinHeight, height);
+			mMaxHeight = std::max(mMaxHeight, height);
+		}
+		if (mStatistics & SAMPLEVARIANCE)
+		{
+			float delta = height - mVarianceMean;
+			mVarianceMean += delta / mCount;
+			mVarianceSum += delta * (height - mVarianceMean);
+		}
+	}
+
+	/*
+	 * Getters, the fallbacks are returned when no point was added
+	 */
+	size_t GetCount() const { return mCount; }
+	bool IsEmpty() const { return mCount == 0; }
+	float GetMeanHeight(float fallback = 0.f) const { return mCount ? mHeightSum / mCount : fallback; }
+	glm::vec3 GetMeanColor(const glm::vec3& fallback = glm::vec3(1.f)) const { return mCount ? mColorSum / static_cast<float>(mCount) : fallback; }
+	float GetMinHeight(float fallback = 0.f) const { return mCount && (mStatistics & SAMPLEMINMAX) ? mMinHeight : fallback; }
+	float GetMaxHeight(float fallback = 0.f) const { return mCount && (mStatistics & SAMPLEMINMAX) ? mMaxHeight : fallback; }
+	// Population variance of the heights
+	float GetHeightVariance(float fallback = 0.f) const { return mCount && (mStatistics & SAMPLEVARIANCE) ? mVarianceSum / mCount : fallback; }
+
+private:
+	/*
+	 * Private Member Variables
+	 */
+	uint32_t mStatistics{ 0 };
+	float mHeightSum{ 0.f };
+	glm::vec3 mColorSum{ 0.f };
+	size_t mCount{ 0 };
+	float mMinHeight{ std::numeric_limits<float>::max() };
+	float mMaxHeight{ std::numeric_limits<float>::lowest() };
+	float mVarianceMean{ 0.f };
+	float mVarianceSum{ 0.f };
+};
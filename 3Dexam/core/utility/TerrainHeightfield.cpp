@@ -0,0 +1,346 @@
+#include "TerrainHeightfield.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+
+#include "graphical/Mesh.h"
+#include "PointKernels.h"
+
+static_assert(sizeof(glm::vec3) == 3 * sizeof(float), "The batch kernels read and write normals as packed floats");
+
+TerrainHeightfield::TerrainHeightfield(const std::vector<Vertex>& gridVertices, int resolution)
+{
+	if (resolution < 2 || gridVertices.size() < static_cast<size_t>(resolution) * resolution) return;
+
+	// Grid placement from the corner vertices, the same way TerrainRenderer places its height texture
+	mResolution = resolution;
+	int cells = resolution - 1;
+	const glm::vec3& lastVertex = gridVertices[static_cast<size_t>(resolution) * resolution - 1].mPosition;
+	mOrigin = glm::vec2(gridVertices[0].mPosition.x, gridVertices[0].mPosition.z);
+	mSpacing = (glm::vec2(lastVertex.x, lastVertex.z) - mOrigin) / static_cast<float>(cells);
+	mInverseSpacing = 1.f / mSpacing;
+
+	size_t vertexCount = static_cast<size_t>(resolution) * resolution;
+	mHeights.resize(vertexCount);
+	mNormals.resize(vertexCount);
+	for (size_t vertex = 0; vertex < vertexCount; ++vertex)
+	{
+		mHeights[vertex] = gridVertices[vertex].mPosition.y;
+		mNormals[vertex] = gridVertices[vertex].mNormal;
+	}
+	BuildHeightRanges();
+}
+
+void TerrainHeightfield::BuildHeightRanges()
+{
+	// Level 0 holds the lowest and highest corner of every cell, which bounds both of its triangles
+	int cells = mResolution - 1;
+	mHeightRanges.clear();
+	mHeightRanges.emplace_back(static_cast<size_t>(cells) * cells);
+	for (int i = 0; i < cells; ++i)
+	{
+		for (int j = 0; j < cells; ++j)
+		{
+			float corners[4] = { GetHeight(i, j), GetHeight(i + 1, j), GetHeight(i, j + 1), GetHeight(i + 1, j + 1) };
+			mHeightRanges[0][static_cast<size_t>(i) * cells + j] = glm::vec2(*std::min_element(corners, corners + 4), *std::max_element(corners, corners + 4));
+		}
+	}
+
+	// Every level above merges 2 x 2 blocks, a block on an odd edge merges what is there, until one block covers the grid
+	int blocks = cells;
+	while (blocks > 1)
+	{
+		int parentBlocks = (blocks + 1) / 2;
+		std::vector<glm::vec2> parentRanges(static_cast<size_t>(parentBlocks) * parentBlocks, glm::vec2(std::numeric_limits<float>::max(), std::numeric_limits<float>::lowest()));
+		const std::vector<glm::vec2>& childRanges = mHeightRanges.back();
+		for (int i = 0; i < blocks; ++i)
+		{
+			for (int j = 0; j < blocks; ++j)
+			{
+				const glm::vec2& child = childRanges[static_cast<size_t>(i) * blocks + j];
+				glm::vec2& parent = parentRanges[static_cast<size_t>(i / 2) * parentBlocks + j / 2];
+				parent.x = std::min(parent.x, child.x);
+				parent.y = std::max(parent.y, child.y);
+			}
+		}
+		mHeightRanges.push_back(std::move(parentRanges));
+		blocks = parentBlocks;
+	}
+}
+
+bool TerrainHeightfield::LocateCell(float x, float z, int& i, int& j, float& cellX, float& cellZ) const
+{
+	if (IsEmpty()) return false;
+
+	// Grid coordinates, a point on the far edge belongs to the last cell
+	float gridX = (x - mOrigin.x) * mInverseSpacing.x;
+	float gridZ = (z - mOrigin.y) * mInverseSpacing.y;
+	int cells = mResolution - 1;
+	if (!(gridX >= -EdgeTolerance && gridX <= cells + EdgeTolerance && gridZ >= -EdgeTolerance && gridZ <= cells + EdgeTolerance)) return false;
+
+	i = std::clamp(static_cast<int>(gridX), 0, cells - 1);
+	j = std::clamp(static_cast<int>(gridZ), 0, cells - 1);
+	cellX = std::clamp(gridX - i, 0.f, 1.f);
+	cellZ = std::clamp(gridZ - j, 0.f, 1.f);
+	return true;
+}
+
+bool TerrainHeightfield::Contains(float x, float z) const
+{
+	int i, j;
+	float cellX, cellZ;
+	return LocateCell(x, z, i, j, cellX, cellZ);
+}
+
+bool TerrainHeightfield::Sample(float x, float z, HeightfieldSample& sample) const
+{
+	int i, j;
+	float cellX, cellZ;
+	if (!LocateCell(x, z, i, j, cellX, cellZ)) return false;
+
+	// The first cell triangle is (i, j), (i + 1, j), (i, j + 1), the second (i + 1, j), (i + 1, j + 1), (i, j + 1)
+	size_t cell = static_cast<size_t>(i) * (mResolution - 1) + j;
+	sample.triangle = cell * 2 + (cellX + cellZ > 1.f ? 1 : 0);
+	if (cellX + cellZ <= 1.f)
+	{
+		sample.barycentric = glm::vec3(1.f - cellX - cellZ, cellX, cellZ);
+	}
+	else
+	{
+		sample.barycentric = glm::vec3(1.f - cellZ, cellX + cellZ - 1.f, 1.f - cellX);
+	}
+
+	size_t corners[3];
+	GetTriangleCorners(sample.triangle, corners);
+	sample.height = sample.barycentric.x * mHeights[corners[0]] + sample.barycentric.y * mHeights[corners[1]] + sample.barycentric.z * mHeights[corners[2]];
+	sample.normal = glm::normalize(sample.barycentric.x * mNormals[corners[0]] + sample.barycentric.y * mNormals[corners[1]] + sample.barycentric.z * mNormals[corners[2]]);
+	return true;
+}
+
+bool TerrainHeightfield::SampleHeight(float x, float z, float& height) const
+{
+	HeightfieldSample sample;
+	if (!Sample(x, z, sample)) return false;
+	height = sample.height;
+	return true;
+}
+
+bool TerrainHeightfield::SampleBatch(std::span<const float> x, std::span<const float> z, std::span<float> heights, std::span<glm::vec3> normals, std::span<uint8_t> hits) const
+{
+	size_t count = x.size();
+	if (z.size() != count || heights.size() != count || hits.size() != count || (!normals.empty() && normals.size() != count))
+	{
+		std::cerr << "Heightfield batch query needs one output per position" << std::endl;
+		return false;
+	}
+	if (IsEmpty())
+	{
+		std::fill(hits.begin(), hits.end(), uint8_t(0));
+		return true;
+	}
+
+	GridSampleLayout grid;
+	grid.heights = mHeights.data();
+	grid.normals = &mNormals[0].x;
+	grid.resolution = mResolution;
+	grid.originX = mOrigin.x;
+	grid.originZ = mOrigin.y;
+	grid.inverseSpacingX = mInverseSpacing.x;
+	grid.inverseSpacingZ = mInverseSpacing.y;
+	grid.edgeTolerance = EdgeTolerance;
+	PointKernels::SampleGridTriangles(x.data(), z.data(), count, grid, heights.data(), normals.empty() ? nullptr : &normals[0].x, hits.data());
+	return true;
+}
+
+float TerrainHeightfield::SampleHeightBilinear(float x, float z) const
+{
+	if (IsEmpty()) return 0.f;
+
+	// Clamped to the grid, so positions outside take the height of the nearest edge
+	int cells = mResolution - 1;
+	float gridX = std::clamp((x - mOrigin.x) * mInverseSpacing.x, 0.f, static_cast<float>(cells));
+	float gridZ = std::clamp((z - mOrigin.y) * mInverseSpacing.y, 0.f, static_cast<float>(cells));
+	int i = std::min(static_cast<int>(gridX), cells - 1);
+	int j = std::min(static_cast<int>(gridZ), cells - 1);
+	float cellX = gridX - i;
+	float cellZ = gridZ - j;
+
+	float nearHeight = glm::mix(GetHeight(i, j), GetHeight(i + 1, j), cellX);
+	float farHeight = glm::mix(GetHeight(i, j + 1), GetHeight(i + 1, j + 1), cellX);
+	return glm::mix(nearHeight, farHeight, cellZ);
+}
+
+glm::vec3 TerrainHeightfield::SampleNormalBilinear(float x, float z) const
+{
+	if (IsEmpty()) return glm::vec3(0.f, -1.f, 0.f);
+
+	int cells = mResolution - 1;
+	float gridX = std::clamp((x - mOrigin.x) * mInverseSpacing.x, 0.f, static_cast<float>(cells));
+	float gridZ = std::clamp((z - mOrigin.y) * mInverseSpacing.y, 0.f, static_cast<float>(cells));
+	int i = std::min(static_cast<int>(gridX), cells - 1);
+	int j = std::min(static_cast<int>(gridZ), cells - 1);
+	float cellX = gridX - i;
+	float cellZ = gridZ - j;
+
+	glm::vec3 nearNormal = glm::mix(GetNormal(i, j), GetNormal(i + 1, j), cellX);
+	glm::vec3 farNormal = glm::mix(GetNormal(i, j + 1), GetNormal(i + 1, j + 1), cellX);
+	return glm::normalize(glm::mix(nearNormal, farNormal, cellZ));
+}
+
+void TerrainHeightfield::GetTriangleCorners(size_t triangle, size_t corners[3]) const
+{
+	size_t cell = triangle / 2;
+	size_t i = cell / (mResolution - 1);
+	size_t j = cell % (mResolution - 1);
+	size_t index0 = i * mResolution + j;
+	size_t index1 = index0 + mResolution;
+	size_t index2 = index0 + 1;
+	if (triangle % 2 == 0)
+	{
+		corners[0] = index0;
+		corners[1] = index1;
+		corners[2] = index2;
+	}
+	else
+	{
+		corners[0] = index1;
+		corners[1] = index1 + 1;
+		corners[2] = index2;
+	}
+}
+
+bool TerrainHeightfield::Raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, HeightfieldRayHit& hit) const
+{
+	if (IsEmpty()) return false;
+
+	// The ray in grid units for x and z, heights stay in model units
+	int cells = mResolution - 1;
+	glm::vec2 gridOrigin((origin.x - mOrigin.x) * mInverseSpacing.x, (origin.z - mOrigin.y) * mInverseSpacing.y);
+	glm::vec2 gridDirection(direction.x * mInverseSpacing.x, direction.z * mInverseSpacing.y);
+
+	// Clipping the ray to the box around the whole terrain
+	const glm::vec2& totalRange = mHeightRanges.back()[0];
+	float boxMin[3] = { 0.f, totalRange.x, 0.f };
+	float boxMax[3] = { static_cast<float>(cells), totalRange.y, static_cast<float>(cells) };
+	float rayOrigin[3] = { gridOrigin.x, origin.y, gridOrigin.y };
+	float rayDirection[3] = { gridDirection.x, direction.y, gridDirection.y };
+	float startDistance = 0.f;
+	float endDistance = maxDistance;
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		if (rayDirection[axis] == 0.f)
+		{
+			if (rayOrigin[axis] < boxMin[axis] || rayOrigin[axis] > boxMax[axis]) return false;
+			continue;
+		}
+		float near = (boxMin[axis] - rayOrigin[axis]) / rayDirection[axis];
+		float far = (boxMax[axis] - rayOrigin[axis]) / rayDirection[axis];
+		if (near > far) std::swap(near, far);
+		startDistance = std::max(startDistance, near);
+		endDistance = std::min(endDistance, far);
+	}
+	if (startDistance > endDistance) return false;
+
+	// Stepping block by block, a block whose height range the ray segment misses is skipped, one it touches is opened
+	// a level down until single cells are tested against their two triangles
+	// A step that lands back on the same border moves on by a ten thousandth of a cell, so the walk always advances
+	float largestStep = std::max(std::abs(gridDirection.x), std::abs(gridDirection.y));
+	float minimumStep = largestStep > 0.f ? 1e-4f / largestStep : 0.f;
+	int topLevel = static_cast<int>(mHeightRanges.size()) - 1;
+	int level = topLevel;
+	float distance = startDistance;
+	while (true)
+	{
+		int blockSize = 1 << level;
+		int blocks = (cells + blockSize - 1) >> level;
+		glm::vec2 position = gridOrigin + distance * gridDirection;
+
+		// On a border the ray belongs to the block ahead of it
+		auto GetBlock = [&](float coordinate, float step)
+			{
+				float block = coordinate / blockSize;
+				int index = static_cast<int>(step >= 0.f ? std::floor(block) : std::ceil(block) - 1.f);
+				return std::clamp(index, 0, blocks - 1);
+			};
+		auto GetExit = [&](int block, float start, float step)
+			{
+				if (step > 0.f) return ((block + 1) * blockSize - start) / step;
+				if (step < 0.f) return (block * blockSize - start) / step;
+				return std::numeric_limits<float>::max();
+			};
+		int blockX = GetBlock(position.x, gridDirection.x);
+		int blockZ = GetBlock(position.y, gridDirection.y);
+		float exitX = GetExit(blockX, gridOrigin.x, gridDirection.x);
+		float exitZ = GetExit(blockZ, gridOrigin.y, gridDirection.y);
+		float exitDistance = std::min({ exitX, exitZ, endDistance });
+
+		const glm::vec2& range = mHeightRanges[level][static_cast<size_t>(blockX) * blocks + blockZ];
+		float entryHeight = origin.y + distance * direction.y;
+		float exitHeight = origin.y + exitDistance * direction.y;
+		if (std::max(entryHeight, exitHeight) >= range.x && std::min(entryHeight, exitHeight) <= range.y)
+		{
+			if (level > 0)
+			{
+				level--;
+				continue;
+			}
+			if (IntersectCell(blockX, blockZ, origin, direction, maxDistance, hit)) return true;
+		}
+
+		if (exitDistance >= endDistance) return false;
+		distance = exitDistance > distance ? exitDistance : distance + minimumStep;
+
+		// Moving up only while the crossed border is also a border of the parent block, inside the parent the level stays
+		bool crossesX = exitX <= exitZ;
+		int border = crossesX ? (gridDirection.x > 0.f ? blockX + 1 : blockX) : (gridDirection.y > 0.f ? blockZ + 1 : blockZ);
+		while (level < topLevel && border % 2 == 0)
+		{
+			level++;
+			border /= 2;
+		}
+	}
+}
+
+bool TerrainHeightfield::IntersectCell(int i, int j, const glm::vec3& origin, const glm::vec3& direction, float maxDistance, HeightfieldRayHit& hit) const
+{
+	bool found = false;
+	float bestDistance = maxDistance;
+	size_t cell = static_cast<size_t>(i) * (mResolution - 1) + j;
+	for (size_t triangle = cell * 2; triangle < cell * 2 + 2; ++triangle)
+	{
+		size_t corners[3];
+		GetTriangleCorners(triangle, corners);
+		glm::vec3 positions[3];
+		for (int corner = 0; corner < 3; ++corner)
+		{
+			size_t vertex = corners[corner];
+			positions[corner] = glm::vec3(mOrigin.x + static_cast<float>(vertex / mResolution) * mSpacing.x, mHeights[vertex], mOrigin.y + static_cast<float>(vertex % mResolution) * mSpacing.y);
+		}
+
+		// Moller-Trumbore, both sides of the surface count
+		glm::vec3 edge1 = positions[1] - positions[0];
+		glm::vec3 edge2 = positions[2] - positions[0];
+		glm::vec3 pvec = glm::cross(direction, edge2);
+		float determinant = glm::dot(edge1, pvec);
+		if (std::abs(determinant) < 1e-12f) continue;
+		float inverseDeterminant = 1.f / determinant;
+		glm::vec3 tvec = origin - positions[0];
+		float v = glm::dot(tvec, pvec) * inverseDeterminant;
+		if (v < 0.f || v > 1.f) continue;
+		glm::vec3 qvec = glm::cross(tvec, edge1);
+		float w = glm::dot(direction, qvec) * inverseDeterminant;
+		if (w < 0.f || v + w > 1.f) continue;
+		float distance = glm::dot(edge2, qvec) * inverseDeterminant;
+		if (distance < 0.f || distance > bestDistance) continue;
+
+		found = true;
+		bestDistance = distance;
+		hit.triangle = triangle;
+		hit.barycentric = glm::vec3(1.f - v - w, v, w);
+		hit.point = origin + direction * distance;
+		hit.distance = distance;
+		hit.normal = glm::normalize(hit.barycentric.x * mNormals[corners[0]] + hit.barycentric.y * mNormals[corners[1]] + hit.barycentric.z * mNormals[corners[2]]);
+	}
+	return found;
+}
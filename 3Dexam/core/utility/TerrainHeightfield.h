@@ -0,0 +1,91 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+#include <glm/glm.hpp>
+
+class Vertex;
+
+// Result of a triangle exact heightfield query
+struct HeightfieldSample
+{
+	float height{ 0.f };
+	glm::vec3 normal{ 0.f, -1.f, 0.f };
+	glm::vec3 barycentric{ 0.f }; // Weights of the three triangle corners
+	size_t triangle{ 0 }; // Grid triangle, two per cell in the order Mesh::TriangulateGrid writes them
+};
+
+// Result of a ray query against the heightfield
+struct HeightfieldRayHit
+{
+	glm::vec3 point{ 0.f };
+	glm::vec3 normal{ 0.f, -1.f, 0.f }; // Interpolated vertex normal, the same one Sample() gives at the hit point
+	glm::vec3 barycentric{ 0.f };
+	size_t triangle{ 0 };
+	float distance{ 0.f }; // Along the ray, in lengths of its direction
+};
+
+/*
+ * Terrain heights and normals on the regular grid, without the rest of the render vertices
+ * Grid vertex i * resolution + j sits at origin + (i, j) * spacing, the cells are split into triangles like Mesh::TriangulateGrid does,
+ * so Sample() matches the rendered full resolution surface, and the normals are the vertex normals from Mesh::CalculateNormals
+ * Rays walk the cells with a DDA over a min/max height pyramid, a block of cells the ray passes entirely above or below is skipped in one step
+ * Nothing changes after construction, every query is const and can run from any number of threads
+ */
+class TerrainHeightfield
+{
+public:
+	static constexpr float EdgeTolerance = 1e-4f; // In cells, how far outside the grid a position still samples the edge
+
+	/*
+	 * Constructor
+	 */
+	TerrainHeightfield() = default;
+	TerrainHeightfield(const std::vector<Vertex>& gridVertices, int resolution);
+
+	/*
+	 * Queries, positions are in the terrain mesh's model space
+	 */
+	bool Contains(float x, float z) const;
+	bool Sample(float x, float z, HeightfieldSample& sample) const;
+	bool SampleHeight(float x, float z, float& height) const;
+	float SampleHeightBilinear(float x, float z) const;
+	glm::vec3 SampleNormalBilinear(float x, float z) const;
+	void GetTriangleCorners(size_t triangle, size_t corners[3]) const;
+	// Nearest surface hit along the ray within maxDistance, both sides of the surface count
+	bool Raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, HeightfieldRayHit& hit) const;
+
+	// Sample() over many positions at once with the vector kernels from PointKernels, every output has one entry per position
+	// hits[i] is 1 where Sample() would succeed, with the same height and normal, misses get the values at the nearest grid edge
+	// normals can be left empty when only the heights are needed
+	bool SampleBatch(std::span<const float> x, std::span<const float> z, std::span<float> heights, std::span<glm::vec3> normals, std::span<uint8_t> hits) const;
+
+	/*
+	 * Getters
+	 */
+	bool IsEmpty() const { return mResolution < 2; }
+	int GetResolution() const { return mResolution; }
+	const glm::vec2& GetOrigin() const { return mOrigin; }
+	const glm::vec2& GetSpacing() const { return mSpacing; }
+	float GetHeight(int i, int j) const { return mHeights[static_cast<size_t>(i) * mResolution + j]; }
+	const glm::vec3& GetNormal(int i, int j) const { return mNormals[static_cast<size_t>(i) * mResolution + j]; }
+	const std::vector<float>& GetHeights() const { return mHeights; }
+	const std::vector<glm::vec3>& GetNormals() const { return mNormals; }
+
+private:
+	bool LocateCell(float x, float z, int& i, int& j, float& cellX, float& cellZ) const;
+	void BuildHeightRanges();
+	bool IntersectCell(int i, int j, const glm::vec3& origin, const glm::vec3& direction, float maxDistance, HeightfieldRayHit& hit) const;
+
+	/*
+	 * Private Member Variables
+	 */
+	std::vector<float> mHeights;
+	std::vector<glm::vec3> mNormals;
+	std::vector<std::vector<glm::vec2>> mHeightRanges; // (min, max) height per block, level 0 is one cell, every level above merges 2 x 2 blocks
+	glm::vec2 mOrigin{ 0.f };
+	glm::vec2 mSpacing{ 1.f };
+	glm::vec2 mInverseSpacing{ 1.f };
+	int mResolution{ 0 };
+};
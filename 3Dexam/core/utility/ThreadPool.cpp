@@ -0,0 +1,52 @@
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(unsigned int threadCount)
+{
+	unsigned int workerCount = ResolveThreadCount(threadCount);
+	mWorkers.reserve(workerCount);
+	for (unsigned int i = 0; i < workerCount; ++i)
+	{
+		mWorkers.emplace_back(&ThreadPool::WorkerLoop, this);
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mQueueMutex);
+		mIsStopping = true;
+	}
+	mTaskAvailable.notify_all();
+
+	// Workers finish the queued tasks before they exit
+	for (auto& worker : mWorkers)
+	{
+		worker.join();
+	}
+}
+
+unsigned int ThreadPool::ResolveThreadCount(unsigned int requestedThreads)
+{
+	if (requestedThreads > 0) return requestedThreads;
+
+	// hardware_concurrency is allowed to return 0 when it cannot be determined
+	unsigned int hardwareThreads = std::thread::hardware_concurrency();
+	return hardwareThreads > 0 ? hardwareThreads : 1;
+}
+
+void ThreadPool::WorkerLoop()
+{
+	while (true)
+	{
+		std::function<void()> task;
+		{
+			std::unique_lock<std::mutex> lock(mQueueMutex);
+			mTaskAvailable.wait(lock, [this]() { return mIsStopping || !mTasks.empty(); });
+			if (mIsStopping && mTasks.empty()) return;
+
+			task = std::move(mTasks.front());
+			mTasks.pop();
+		}
+		task();
+	}
+}
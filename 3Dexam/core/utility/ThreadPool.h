@@ -0,0 +1,60 @@
+#pragma once
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/*
+ * Fixed size pool of worker threads, tasks are run in the order they are submitted
+ */
+class ThreadPool
+{
+public:
+	/*
+	 * Constructor and destructor, a thread count of 0 uses every hardware thread
+	 */
+	explicit ThreadPool(unsigned int threadCount = 0);
+	~ThreadPool();
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	/*
+	 * Submitting work
+	 */
+	template <typename Function>
+	std::future<std::invoke_result_t<Function>> Submit(Function&& function)
+	{
+		using ResultType = std::invoke_result_t<Function>;
+		auto task = std::make_shared<std::packaged_task<ResultType()>>(std::forward<Function>(function));
+		std::future<ResultType> result = task->get_future();
+		{
+			std::lock_guard<std::mutex> lock(mQueueMutex);
+			mTasks.emplace([task]() { (*task)(); });
+		}
+		mTaskAvailable.notify_one();
+		return result;
+	}
+
+	/*
+	 * Getters and helpers
+	 */
+	unsigned int GetThreadCount() const { return static_cast<unsigned int>(mWorkers.size()); }
+	static unsigned int ResolveThreadCount(unsigned int requestedThreads);
+
+private:
+	void WorkerLoop();
+
+	/*
+	 * Private Member Variables
+	 */
+	std::vector<std::thread> mWorkers;
+	std::queue<std::function<void()>> mTasks;
+	std::mutex mQueueMutex;
+	std::condition_variable mTaskAvailable;
+	bool mIsStopping{ false };
+};
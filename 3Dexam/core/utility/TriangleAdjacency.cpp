@@ -0,0 +1,93 @@
+#include "TriangleAdjacency.h"
+#include <algorithm>
+
+#include "graphical/Mesh.h"
+
+void TriangleAdjacency::Build(const std::vector<Index>& indices)
+{
+	size_t triangleCount = indices.size() / 3;
+	mNeighbours.assign(triangleCount * 3, NoNeighbour);
+
+	// Every edge keyed by its two vertices, smallest first, sorting puts the two sides of a shared edge next to each other
+	struct HalfEdge
+	{
+		uint64_t key;
+		uint32_t edge; // triangle * 3 + edge number
+	};
+	std::vector<HalfEdge> halfEdges(triangleCount * 3);
+	for (size_t triangle = 0; triangle < triangleCount; ++triangle)
+	{
+		for (int edge = 0; edge < 3; ++edge)
+		{
+			uint64_t from = indices[triangle * 3 + edge];
+			uint64_t to = indices[triangle * 3 + (edge + 1) % 3];
+			halfEdges[triangle * 3 + edge] = { std::min(from, to) << 32 | std::max(from, to), static_cast<uint32_t>(triangle * 3 + edge) };
+		}
+	}
+	std::sort(halfEdges.begin(), halfEdges.end(), [](const HalfEdge& a, const HalfEdge& b) { return a.key < b.key || (a.key == b.key && a.edge < b.edge); });
+
+	// Pairing the sides, an edge shared by more than two triangles is left as a border after the first pair
+	for (size_t halfEdge = 0; halfEdge + 1 < halfEdges.size(); ++halfEdge)
+	{
+		if (halfEdges[halfEdge].key != halfEdges[halfEdge + 1].key) continue;
+
+		uint32_t first = halfEdges[halfEdge].edge;
+		uint32_t second = halfEdges[halfEdge + 1].edge;
+		mNeighbours[first] = second / 3;
+		mNeighbours[second] = first / 3;
+		while (halfEdge + 1 < halfEdges.size() && halfEdges[halfEdge + 1].key == halfEdges[halfEdge].key)
+		{
+			halfEdge++;
+		}
+	}
+}
+
+bool TriangleAdjacency::Walk(const std::vector<Vertex>& vertices, const std::vector<Index>& indices, size_t startTriangle, float x, float z, size_t& triangle, glm::vec3& barycentric, int maxSteps) const
+{
+	if (startTriangle >= mNeighbours.size() / 3) return false;
+
+	const float tolerance = 1e-5f;
+	glm::vec2 target(x, z);
+	size_t current = startTriangle;
+	size_t previous = NoNeighbour;
+	for (int step = 0; step <= maxSteps; ++step)
+	{
+		const glm::vec3& p = vertices[indices[current * 3]].mPosition;
+		const glm::vec3& q = vertices[indices[current * 3 + 1]].mPosition;
+		const glm::vec3& r = vertices[indices[current * 3 + 2]].mPosition;
+		glm::vec2 P(p.x, p.z), Q(q.x, q.z), R(r.x, r.z);
+
+		// Same weights as TriangleBinIndex::FindTriangle, so the result does not depend on which lookup found the triangle
+		float area = (Q.x - P.x) * (R.y - P.y) - (R.x - P.x) * (Q.y - P.y);
+		if (area == 0.f) return false;
+		float U = ((Q.x - target.x) * (R.y - target.y) - (R.x - target.x) * (Q.y - target.y)) / area;
+		float V = ((R.x - target.x) * (P.y - target.y) - (P.x - target.x) * (R.y - target.y)) / area;
+		float W = 1.f - U - V;
+		if (U >= -tolerance && V >= -tolerance && W >= -tolerance)
+		{
+			triangle = current;
+			barycentric = glm::vec3(U, V, W);
+			return true;
+		}
+
+		// Crossing the edge opposite the most negative weight, U is opposite edge 1 (Q to R), V edge 2 (R to P) and W edge 0 (P to Q)
+		float weights[3] = { W, U, V };
+		int edges[3] = { 0, 1, 2 };
+		std::sort(edges, edges + 3, [&](int a, int b) { return weights[a] < weights[b]; });
+
+		// The second most negative edge is taken when the first leads straight back, which breaks the usual two triangle cycle
+		size_t next = NoNeighbour;
+		for (int edge : edges)
+		{
+			if (weights[edge] >= -tolerance) break;
+			uint32_t neighbour = mNeighbours[current * 3 + edge];
+			if (neighbour == NoNeighbour || neighbour == previous) continue;
+			next = neighbour;
+			break;
+		}
+		if (next == NoNeighbour) return false;
+		previous = current;
+		current = next;
+	}
+	return false;
+}
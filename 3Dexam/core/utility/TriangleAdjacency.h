@@ -0,0 +1,33 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "utility/VariableTypes.h"
+
+class Vertex;
+
+/*
+ * Edge adjacency of an indexed triangle mesh, the triangle across each of the three edges of every triangle
+ * Edge k of a triangle runs from corner k to corner k + 1, edges with no triangle on the other side are marked NoNeighbour
+ * Walk() uses it to find the triangle under a position by stepping across edges from a nearby start triangle,
+ * which is close to constant time when the start is where the same query landed a frame earlier
+ */
+class TriangleAdjacency
+{
+public:
+	static constexpr uint32_t NoNeighbour = UINT32_MAX;
+
+	void Build(const std::vector<Index>& indices);
+
+	uint32_t GetNeighbour(size_t triangle, int edge) const { return mNeighbours[triangle * 3 + edge]; }
+
+	// Steps from startTriangle towards (x, z) in the xz plane, false when it leaves the mesh or takes more than maxSteps steps
+	bool Walk(const std::vector<Vertex>& vertices, const std::vector<Index>& indices, size_t startTriangle, float x, float z, size_t& triangle, glm::vec3& barycentric, int maxSteps = 64) const;
+
+private:
+	/*
+	 * Private Member Variables
+	 */
+	std::vector<uint32_t> mNeighbours;
+};
@@ -0,0 +1,465 @@
+#include "TriangleBVH.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "graphical/Mesh.h"
+
+namespace
+{
+	constexpr int SplitBins = 16;
+	constexpr int MaxStackSize = 256;
+
+	struct BuildBounds
+	{
+		glm::vec3 min{ std::numeric_limits<float>::max() };
+		glm::vec3 max{ std::numeric_limits<float>::lowest() };
+
+		void Grow(const glm::vec3& point) { min = glm::min(min, point); max = glm::max(max, point); }
+		void Grow(const BuildBounds& other) { min = glm::min(min, other.min); max = glm::max(max, other.max); }
+		float HalfArea() const
+		{
+			if (min.x > max.x) return 0.f;
+			glm::vec3 extent = max - min;
+			return extent.x * extent.y + extent.y * extent.z + extent.z * extent.x;
+		}
+	};
+
+	// Binary hierarchy the 4 wide nodes are collapsed from, a leaf has no children and owns order[first, first + count)
+	struct BinaryNode
+	{
+		BuildBounds bounds;
+		uint32_t left{ 0 };
+		uint32_t right{ 0 };
+		uint32_t first{ 0 };
+		uint32_t count{ 0 };
+		bool IsLeaf() const { return left == right; }
+	};
+
+	struct BinaryBuilder
+	{
+		const std::vector<BuildBounds>& triangleBounds;
+		const std::vector<glm::vec3>& centroids;
+		std::vector<uint32_t>& order;
+		std::vector<BinaryNode> nodes;
+
+		uint32_t Split(uint32_t first, uint32_t count)
+		{
+			uint32_t nodeIndex = static_cast<uint32_t>(nodes.size());
+			nodes.emplace_back();
+			BuildBounds bounds, centroidBounds;
+			for (uint32_t i = first; i < first + count; ++i)
+			{
+				bounds.Grow(triangleBounds[order[i]]);
+				centroidBounds.Grow(centroids[order[i]]);
+			}
+			nodes[nodeIndex].bounds = bounds;
+			nodes[nodeIndex].first = first;
+			nodes[nodeIndex].count = count;
+			if (count <= 1) return nodeIndex;
+
+			// Cheapest binned split over all three axes, costs are in triangle tests with one node visit costing the same as one test
+			float bestCost = std::numeric_limits<float>::max();
+			int bestAxis = -1;
+			int bestBin = 0;
+			glm::vec3 centroidExtent = centroidBounds.max - centroidBounds.min;
+			for (int axis = 0; axis < 3; ++axis)
+			{
+				if (centroidExtent[axis] <= 0.f) continue;
+
+				BuildBounds binBounds[SplitBins];
+				uint32_t binCounts[SplitBins] = {};
+				float binScale = SplitBins / centroidExtent[axis];
+				for (uint32_t i = first; i < first + count; ++i)
+				{
+					int bin = std::min(static_cast<int>((centroids[order[i]][axis] - centroidBounds.min[axis]) * binScale), SplitBins - 1);
+					binBounds[bin].Grow(triangleBounds[order[i]]);
+					binCounts[bin]++;
+				}
+
+				// Sweeping from the right first, then from the left, every bin boundary is a candidate split
+				float rightCosts[SplitBins] = {};
+				BuildBounds rightBounds;
+				uint32_t rightCount = 0;
+				for (int bin = SplitBins - 1; bin > 0; --bin)
+				{
+					rightBounds.Grow(binBounds[bin]);
+					rightCount += binCounts[bin];
+					rightCosts[bin] = rightBounds.HalfArea() * rightCount;
+				}
+				BuildBounds leftBounds;
+				uint32_t leftCount = 0;
+				for (int bin = 0; bin < SplitBins - 1; ++bin)
+				{
+					leftBounds.Grow(binBounds[bin]);
+					leftCount += binCounts[bin];
+					if (leftCount == 0 || leftCount == count) continue;
+					float cost = leftBounds.HalfArea() * leftCount + rightCosts[bin + 1];
+					if (cost < bestCost)
+					{
+						bestCost = cost;
+						bestAxis = axis;
+						bestBin = bin;
+					}
+				}
+			}
+
+			float leafCost = bounds.HalfArea() * count;
+			float splitCost = bounds.HalfArea() + bestCost;
+			if (count <= TriangleBVH::MaxLeafTriangles && (bestAxis < 0 || leafCost <= splitCost)) return nodeIndex;
+
+			uint32_t middle;
+			if (bestAxis >= 0)
+			{
+				float binScale = SplitBins / centroidExtent[bestAxis];
+				float splitMin = centroidBounds.min[bestAxis];
+				auto split = std::partition(order.begin() + first, order.begin() + first + count, [&](uint32_t triangle)
+					{
+						return std::min(static_cast<int>((centroids[triangle][bestAxis] - splitMin) * binScale), SplitBins - 1) <= bestBin;
+					});
+				middle = static_cast<uint32_t>(split - order.begin());
+			}
+			else
+			{
+				// All centroids in one point, halving keeps the leaves small
+				middle = first + count / 2;
+			}
+
+			uint32_t left = Split(first, middle - first);
+			uint32_t right = Split(middle, first + count - middle);
+			nodes[nodeIndex].left = left;
+			nodes[nodeIndex].right = right;
+			return nodeIndex;
+		}
+	};
+
+	// Closest point on triangle abc to p, Ericson's Real-Time Collision Detection 5.1.5
+	glm::vec3 ClosestPointOnTriangle(const glm::vec3& p, const glm::vec3& a, const glm::vec3& b, const glm::vec3& c)
+	{
+		glm::vec3 ab = b - a, ac = c - a, ap = p - a;
+		float d1 = glm::dot(ab, ap), d2 = glm::dot(ac, ap);
+		if (d1 <= 0.f && d2 <= 0.f) return a;
+
+		glm::vec3 bp = p - b;
+		float d3 = glm::dot(ab, bp), d4 = glm::dot(ac, bp);
+		if (d3 >= 0.f && d4 <= d3) return b;
+
+		float vc = d1 * d4 - d3 * d2;
+		if (vc <= 0.f && d1 >= 0.f && d3 <= 0.f) return a + ab * (d1 / (d1 - d3));
+
+		glm::vec3 cp = p - c;
+		float d5 = glm::dot(ab, cp), d6 = glm::dot(ac, cp);
+		if (d6 >= 0.f && d5 <= d6) return c;
+
+		float vb = d5 * d2 - d1 * d6;
+		if (vb <= 0.f && d2 >= 0.f && d6 <= 0.f) return a + ac * (d2 / (d2 - d6));
+
+		float va = d3 * d6 - d5 * d4;
+		if (va <= 0.f && (d4 - d3) >= 0.f && (d5 - d6) >= 0.f) return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+
+		float denominator = 1.f / (va + vb + vc);
+		return a + ab * (vb * denominator) + ac * (vc * denominator);
+	}
+}
+
+void TriangleBVH::Build(const std::vector<Vertex>& vertices, const std::vector<Index>& indices)
+{
+	mNodes.clear();
+	mTriangles.clear();
+	mDepth = 0;
+
+	size_t triangleCount = indices.size() / 3;
+	if (triangleCount == 0) return;
+
+	std::vector<BuildBounds> triangleBounds(triangleCount);
+	std::vector<glm::vec3> centroids(triangleCount);
+	std::vector<uint32_t> order(triangleCount);
+	for (size_t triangle = 0; triangle < triangleCount; ++triangle)
+	{
+		for (int corner = 0; corner < 3; ++corner)
+		{
+			triangleBounds[triangle].Grow(vertices[indices[triangle * 3 + corner]].mPosition);
+		}
+		centroids[triangle] = 0.5f * (triangleBounds[triangle].min + triangleBounds[triangle].max);
+		order[triangle] = static_cast<uint32_t>(triangle);
+	}
+
+	BinaryBuilder builder{ triangleBounds, centroids, order, {} };
+	builder.nodes.reserve(triangleCount * 2);
+	builder.Split(0, static_cast<uint32_t>(triangleCount));
+
+	// Collapsing, the binary children with the largest surface are opened until a node has four children or only leaves are left
+	mNodes.reserve(builder.nodes.size() / 2 + 1);
+	mTriangles.reserve(triangleCount);
+	auto Collapse = [&](auto& self, uint32_t binaryIndex, int depth) -> uint32_t
+		{
+			mDepth = std::max(mDepth, depth);
+			uint32_t children[4];
+			int childCount = 0;
+			const BinaryNode& binaryNode = builder.nodes[binaryIndex];
+			if (binaryNode.IsLeaf())
+			{
+				children[childCount++] = binaryIndex;
+			}
+			else
+			{
+				children[childCount++] = binaryNode.left;
+				children[childCount++] = binaryNode.right;
+			}
+			while (childCount < 4)
+			{
+				int widest = -1;
+				float widestArea = -1.f;
+				for (int child = 0; child < childCount; ++child)
+				{
+					const BinaryNode& candidate = builder.nodes[children[child]];
+					if (!candidate.IsLeaf() && candidate.bounds.HalfArea() > widestArea)
+					{
+						widest = child;
+						widestArea = candidate.bounds.HalfArea();
+					}
+				}
+				if (widest < 0) break;
+
+				const BinaryNode& opened = builder.nodes[children[widest]];
+				children[widest] = opened.left;
+				children[childCount++] = opened.right;
+			}
+
+			uint32_t nodeIndex = static_cast<uint32_t>(mNodes.size());
+			mNodes.emplace_back();
+			for (int child = 0; child < 4; ++child)
+			{
+				Node& node = mNodes[nodeIndex];
+				if (child >= childCount)
+				{
+					// Empty boxes never overlap anything
+					node.minX[child] = node.minY[child] = node.minZ[child] = std::numeric_limits<float>::max();
+					node.maxX[child] = node.maxY[child] = node.maxZ[child] = std::numeric_limits<float>::lowest();
+					node.child[child] = 0;
+					node.triangleCount[child] = EmptyChild;
+					continue;
+				}
+
+				const BinaryNode& binaryChild = builder.nodes[children[child]];
+				node.minX[child] = binaryChild.bounds.min.x;
+				node.minY[child] = binaryChild.bounds.min.y;
+				node.minZ[child] = binaryChild.bounds.min.z;
+				node.maxX[child] = binaryChild.bounds.max.x;
+				node.maxY[child] = binaryChild.bounds.max.y;
+				node.maxZ[child] = binaryChild.bounds.max.z;
+				if (binaryChild.IsLeaf())
+				{
+					node.child[child] = static_cast<uint32_t>(mTriangles.size());
+					node.triangleCount[child] = binaryChild.count;
+					for (uint32_t i = binaryChild.first; i < binaryChild.first + binaryChild.count; ++i)
+					{
+						LeafTriangle leafTriangle;
+						for (int corner = 0; corner < 3; ++corner)
+						{
+							leafTriangle.corners[corner] = vertices[indices[static_cast<size_t>(order[i]) * 3 + corner]].mPosition;
+						}
+						leafTriangle.triangle = order[i];
+						mTriangles.push_back(leafTriangle);
+					}
+				}
+				else
+				{
+					// The recursion may grow mNodes, so the slot is looked up again afterwards
+					uint32_t childNode = self(self, children[child], depth + 1);
+					mNodes[nodeIndex].child[child] = childNode;
+					mNodes[nodeIndex].triangleCount[child] = 0;
+				}
+			}
+			return nodeIndex;
+		};
+	Collapse(Collapse, 0, 1);
+}
+
+bool TriangleBVH::ProjectDown(float x, float z, float fromHeight, TriangleHit& hit) const
+{
+	if (IsEmpty()) return false;
+
+	const float tolerance = 1e-5f;
+	bool found = false;
+	float bestHeight = std::numeric_limits<float>::lowest();
+	uint32_t stack[MaxStackSize];
+	int stackSize = 0;
+	stack[stackSize++] = 0;
+	while (stackSize > 0)
+	{
+		const Node& node = mNodes[stack[--stackSize]];
+		for (int child = 0; child < 4; ++child)
+		{
+			// Boxes entirely above the start or below the best surface so far can not hold a better one
+			if (x < node.minX[child] || x > node.maxX[child] || z < node.minZ[child] || z > node.maxZ[child]) continue;
+			if (node.minY[child] > fromHeight || node.maxY[child] <= bestHeight) continue;
+
+			if (node.triangleCount[child] == 0)
+			{
+				if (stackSize < MaxStackSize) stack[stackSize++] = node.child[child];
+				continue;
+			}
+			for (uint32_t leaf = node.child[child]; leaf < node.child[child] + node.triangleCount[child]; ++leaf)
+			{
+				const glm::vec3& p = mTriangles[leaf].corners[0];
+				const glm::vec3& q = mTriangles[leaf].corners[1];
+				const glm::vec3& r = mTriangles[leaf].corners[2];
+
+				// Same xz weights as TriangleBinIndex::FindTriangle, either winding is accepted
+				float area = (q.x - p.x) * (r.z - p.z) - (r.x - p.x) * (q.z - p.z);
+				if (area == 0.f) continue;
+				float U = ((q.x - x) * (r.z - z) - (r.x - x) * (q.z - z)) / area;
+				float V = ((r.x - x) * (p.z - z) - (p.x - x) * (r.z - z)) / area;
+				float W = 1.f - U - V;
+				if (U < -tolerance || V < -tolerance || W < -tolerance) continue;
+
+				float height = U * p.y + V * q.y + W * r.y;
+				if (height > fromHeight || height <= bestHeight) continue;
+
+				found = true;
+				bestHeight = height;
+				hit.triangle = mTriangles[leaf].triangle;
+				hit.barycentric = glm::vec3(U, V, W);
+				hit.point = glm::vec3(x, height, z);
+				hit.distance = fromHeight - height;
+				glm::vec3 normal = glm::normalize(glm::cross(q - p, r - p));
+				hit.normal = normal.y < 0.f ? -normal : normal;
+			}
+		}
+	}
+	return found;
+}
+
+bool TriangleBVH::Raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, TriangleHit& hit) const
+{
+	if (IsEmpty()) return false;
+
+	// Axis parallel rays get a tiny component instead of zero, which keeps the slab test free of 0 * infinity
+	glm::vec3 inverseDirection;
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		float component = std::abs(direction[axis]) < 1e-20f ? std::copysign(1e-20f, direction[axis]) : direction[axis];
+		inverseDirection[axis] = 1.f / component;
+	}
+
+	bool found = false;
+	float bestDistance = maxDistance;
+	struct StackEntry
+	{
+		uint32_t node;
+		float entry;
+	};
+	StackEntry stack[MaxStackSize];
+	int stackSize = 0;
+	stack[stackSize++] = { 0, 0.f };
+	while (stackSize > 0)
+	{
+		StackEntry current = stack[--stackSize];
+		if (current.entry > bestDistance) continue;
+		const Node& node = mNodes[current.node];
+
+		// Slab test against the four boxes, the lanes are independent so the compiler can keep them in one vector register
+		float entries[4];
+		bool hits[4];
+		for (int child = 0; child < 4; ++child)
+		{
+			float near0 = (node.minX[child] - origin.x) * inverseDirection.x;
+			float far0 = (node.maxX[child] - origin.x) * inverseDirection.x;
+			float near1 = (node.minY[child] - origin.y) * inverseDirection.y;
+			float far1 = (node.maxY[child] - origin.y) * inverseDirection.y;
+			float near2 = (node.minZ[child] - origin.z) * inverseDirection.z;
+			float far2 = (node.maxZ[child] - origin.z) * inverseDirection.z;
+			float entry = std::max({ std::min(near0, far0), std::min(near1, far1), std::min(near2, far2), 0.f });
+			float exit = std::min({ std::max(near0, far0), std::max(near1, far1), std::max(near2, far2), bestDistance });
+			entries[child] = entry;
+			hits[child] = entry <= exit && node.triangleCount[child] != EmptyChild;
+		}
+
+		// Leaves are tested straight away, inner children are pushed far to near so the nearest is visited first
+		int innerChildren[4];
+		int innerCount = 0;
+		for (int child = 0; child < 4; ++child)
+		{
+			if (!hits[child]) continue;
+			if (node.triangleCount[child] == 0)
+			{
+				innerChildren[innerCount++] = child;
+				continue;
+			}
+			for (uint32_t leaf = node.child[child]; leaf < node.child[child] + node.triangleCount[child]; ++leaf)
+			{
+				// Moller-Trumbore, both sides of the triangle count
+				const glm::vec3& p = mTriangles[leaf].corners[0];
+				glm::vec3 edge1 = mTriangles[leaf].corners[1] - p;
+				glm::vec3 edge2 = mTriangles[leaf].corners[2] - p;
+				glm::vec3 pvec = glm::cross(direction, edge2);
+				float determinant = glm::dot(edge1, pvec);
+				if (std::abs(determinant) < 1e-12f) continue;
+				float inverseDeterminant = 1.f / determinant;
+				glm::vec3 tvec = origin - p;
+				float v = glm::dot(tvec, pvec) * inverseDeterminant;
+				if (v < 0.f || v > 1.f) continue;
+				glm::vec3 qvec = glm::cross(tvec, edge1);
+				float w = glm::dot(direction, qvec) * inverseDeterminant;
+				if (w < 0.f || v + w > 1.f) continue;
+				float distance = glm::dot(edge2, qvec) * inverseDeterminant;
+				if (distance < 0.f || distance > bestDistance) continue;
+
+				found = true;
+				bestDistance = distance;
+				hit.triangle = mTriangles[leaf].triangle;
+				hit.barycentric = glm::vec3(1.f - v - w, v, w);
+				hit.point = origin + direction * distance;
+				hit.distance = distance;
+				glm::vec3 normal = glm::normalize(glm::cross(edge1, edge2));
+				hit.normal = glm::dot(normal, direction) > 0.f ? -normal : normal;
+			}
+		}
+		std::sort(innerChildren, innerChildren + innerCount, [&](int a, int b) { return entries[a] > entries[b]; });
+		for (int inner = 0; inner < innerCount && stackSize < MaxStackSize; ++inner)
+		{
+			stack[stackSize++] = { node.child[innerChildren[inner]], entries[innerChildren[inner]] };
+		}
+	}
+	return found;
+}
+
+size_t TriangleBVH::OverlapSphere(const glm::vec3& center, float radius, std::vector<TriangleContact>& contacts) const
+{
+	contacts.clear();
+	if (IsEmpty()) return 0;
+
+	float radiusSquared = radius * radius;
+	uint32_t stack[MaxStackSize];
+	int stackSize = 0;
+	stack[stackSize++] = 0;
+	while (stackSize > 0)
+	{
+		const Node& node = mNodes[stack[--stackSize]];
+		for (int child = 0; child < 4; ++child)
+		{
+			// Squared distance from the centre to the box, zero inside
+			float dx = std::max({ node.minX[child] - center.x, 0.f, center.x - node.maxX[child] });
+			float dy = std::max({ node.minY[child] - center.y, 0.f, center.y - node.maxY[child] });
+			float dz = std::max({ node.minZ[child] - center.z, 0.f, center.z - node.maxZ[child] });
+			if (node.triangleCount[child] == EmptyChild || dx * dx + dy * dy + dz * dz > radiusSquared) continue;
+
+			if (node.triangleCount[child] == 0)
+			{
+				if (stackSize < MaxStackSize) stack[stackSize++] = node.child[child];
+				continue;
+			}
+			for (uint32_t leaf = node.child[child]; leaf < node.child[child] + node.triangleCount[child]; ++leaf)
+			{
+				const LeafTriangle& leafTriangle = mTriangles[leaf];
+				glm::vec3 closest = ClosestPointOnTriangle(center, leafTriangle.corners[0], leafTriangle.corners[1], leafTriangle.corners[2]);
+				glm::vec3 offset = closest - center;
+				float distanceSquared = glm::dot(offset, offset);
+				if (distanceSquared > radiusSquared) continue;
+				contacts.push_back({ leafTriangle.triangle, closest, std::sqrt(distanceSquared) });
+			}
+		}
+	}
+	return contacts.size();
+}
@@ -0,0 +1,87 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "utility/VariableTypes.h"
+
+class Vertex;
+
+// Closest triangle found by a ray or vertical query
+struct TriangleHit
+{
+	size_t triangle{ 0 }; // Triangle in index buffer order, corners at indices[triangle * 3 + 0..2]
+	glm::vec3 point{ 0.f };
+	glm::vec3 barycentric{ 0.f }; // Weights of the three triangle corners
+	glm::vec3 normal{ 0.f, 1.f, 0.f }; // Geometric normal, facing against the query direction
+	float distance{ 0.f };
+};
+
+// Triangle touched by a sphere, with the point on the triangle closest to the sphere centre
+struct TriangleContact
+{
+	size_t triangle{ 0 };
+	glm::vec3 point{ 0.f };
+	float distance{ 0.f };
+};
+
+/*
+ * Bounding volume hierarchy over the triangles of any mesh, for meshes that are not a terrain grid
+ * Built top down with binned surface area heuristic splits, then every two levels are collapsed into one 4 wide node
+ * Nodes and triangles live in two flat arrays, a node keeps its four child boxes next to each other (x, y and z lanes)
+ * and the leaf triangles are copied out of the mesh in traversal order, so queries never touch the vertex buffer
+ * Nothing changes after Build(), every query is const and can run from any number of threads
+ */
+class TriangleBVH
+{
+public:
+	static constexpr int MaxLeafTriangles = 4;
+
+	void Build(const std::vector<Vertex>& vertices, const std::vector<Index>& indices);
+
+	/*
+	 * Queries, positions are in the mesh's model space
+	 */
+	// Highest triangle at (x, z) that is not above fromHeight, the mesh surface an object at that height would land on
+	bool ProjectDown(float x, float z, float fromHeight, TriangleHit& hit) const;
+	// Closest triangle along the ray, direction does not have to be normalized but distances are in its length
+	bool Raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, TriangleHit& hit) const;
+	// Every triangle within radius of center, contacts is cleared first, returns the number found
+	size_t OverlapSphere(const glm::vec3& center, float radius, std::vector<TriangleContact>& contacts) const;
+
+	/*
+	 * Getters
+	 */
+	bool IsEmpty() const { return mNodes.empty(); }
+	size_t GetNodeCount() const { return mNodes.size(); }
+	size_t GetTriangleCount() const { return mTriangles.size(); }
+	int GetDepth() const { return mDepth; }
+
+private:
+	// Four child boxes side by side, a child is either another node or a run of leaf triangles
+	struct alignas(64) Node
+	{
+		float minX[4];
+		float minY[4];
+		float minZ[4];
+		float maxX[4];
+		float maxY[4];
+		float maxZ[4];
+		uint32_t child[4]; // Node index, or first leaf triangle when triangleCount is above zero
+		uint32_t triangleCount[4]; // 0 for an inner child, EmptyChild for an unused slot
+	};
+	static constexpr uint32_t EmptyChild = UINT32_MAX;
+
+	struct LeafTriangle
+	{
+		glm::vec3 corners[3];
+		uint32_t triangle;
+	};
+
+	/*
+	 * Private Member Variables
+	 */
+	std::vector<Node> mNodes;
+	std::vector<LeafTriangle> mTriangles;
+	int mDepth{ 0 };
+};
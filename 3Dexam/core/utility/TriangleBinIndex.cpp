@@ -0,0 +1,121 @@
+#include "TriangleBinIndex.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "graphical/Mesh.h"
+
+void TriangleBinIndex::Build(const std::vector<Vertex>& vertices, const std::vector<Index>& indices)
+{
+	mCellStarts.clear();
+	mBinnedTriangles.clear();
+	mCellsX = 0;
+	mCellsZ = 0;
+
+	size_t triangleCount = indices.size() / 3;
+	if (triangleCount == 0) return;
+
+	glm::vec2 minBounds(std::numeric_limits<float>::max());
+	glm::vec2 maxBounds(std::numeric_limits<float>::lowest());
+	for (Index index : indices)
+	{
+		glm::vec2 position(vertices[index].mPosition.x, vertices[index].mPosition.z);
+		minBounds = glm::min(minBounds, position);
+		maxBounds = glm::max(maxBounds, position);
+	}
+
+	// Square cells sized for about two triangles each, capped so a few huge triangles can not blow up the grid
+	glm::vec2 extent = glm::max(maxBounds - minBounds, glm::vec2(1e-6f));
+	float cellSize = std::sqrt(extent.x * extent.y / (0.5f * static_cast<float>(triangleCount)));
+	cellSize = std::max({ cellSize, extent.x / 4096.f, extent.y / 4096.f });
+	mOrigin = minBounds;
+	mInverseCellSize = 1.f / cellSize;
+	mCellsX = std::clamp(static_cast<int>(extent.x * mInverseCellSize) + 1, 1, 4096);
+	mCellsZ = std::clamp(static_cast<int>(extent.y * mInverseCellSize) + 1, 1, 4096);
+
+	// Cell range touched by a triangle's bounding box
+	auto GetCellRange = [&](size_t triangle, glm::ivec2& firstCell, glm::ivec2& lastCell)
+		{
+			glm::vec2 triangleMin(std::numeric_limits<float>::max());
+			glm::vec2 triangleMax(std::numeric_limits<float>::lowest());
+			for (int corner = 0; corner < 3; ++corner)
+			{
+				const glm::vec3& position = vertices[indices[triangle * 3 + corner]].mPosition;
+				triangleMin = glm::min(triangleMin, glm::vec2(position.x, position.z));
+				triangleMax = glm::max(triangleMax, glm::vec2(position.x, position.z));
+			}
+			glm::ivec2 maxCell(mCellsX - 1, mCellsZ - 1);
+			firstCell = glm::clamp(glm::ivec2((triangleMin - mOrigin) * mInverseCellSize), glm::ivec2(0), maxCell);
+			lastCell = glm::clamp(glm::ivec2((triangleMax - mOrigin) * mInverseCellSize), glm::ivec2(0), maxCell);
+		};
+
+	// Counting, prefix summing and scattering, the same passes as CellBinIndex
+	mCellStarts.assign(static_cast<size_t>(mCellsX) * mCellsZ + 1, 0);
+	glm::ivec2 firstCell, lastCell;
+	for (size_t triangle = 0; triangle < triangleCount; ++triangle)
+	{
+		GetCellRange(triangle, firstCell, lastCell);
+		for (int cellX = firstCell.x; cellX <= lastCell.x; ++cellX)
+		{
+			for (int cellZ = firstCell.y; cellZ <= lastCell.y; ++cellZ)
+			{
+				mCellStarts[static_cast<size_t>(cellX) * mCellsZ + cellZ + 1]++;
+			}
+		}
+	}
+	for (size_t cell = 1; cell < mCellStarts.size(); ++cell)
+	{
+		mCellStarts[cell] += mCellStarts[cell - 1];
+	}
+
+	std::vector<uint32_t> cellCursors(mCellStarts.begin(), mCellStarts.end() - 1);
+	mBinnedTriangles.resize(mCellStarts.back());
+	for (size_t triangle = 0; triangle < triangleCount; ++triangle)
+	{
+		GetCellRange(triangle, firstCell, lastCell);
+		for (int cellX = firstCell.x; cellX <= lastCell.x; ++cellX)
+		{
+			for (int cellZ = firstCell.y; cellZ <= lastCell.y; ++cellZ)
+			{
+				mBinnedTriangles[cellCursors[static_cast<size_t>(cellX) * mCellsZ + cellZ]++] = static_cast<uint32_t>(triangle);
+			}
+		}
+	}
+}
+
+bool TriangleBinIndex::FindTriangle(const std::vector<Vertex>& vertices, const std::vector<Index>& indices, float x, float z, size_t& triangle, glm::vec3& barycentric) const
+{
+	if (mCellsX == 0) return false;
+
+	// Points a little outside the bounds still check the edge cells, the barycentric tolerance decides
+	glm::vec2 gridPosition = (glm::vec2(x, z) - mOrigin) * mInverseCellSize;
+	if (gridPosition.x < -1.f || gridPosition.y < -1.f || gridPosition.x > mCellsX + 1.f || gridPosition.y > mCellsZ + 1.f) return false;
+	int cellX = std::clamp(static_cast<int>(gridPosition.x), 0, mCellsX - 1);
+	int cellZ = std::clamp(static_cast<int>(gridPosition.y), 0, mCellsZ - 1);
+	size_t cell = static_cast<size_t>(cellX) * mCellsZ + cellZ;
+
+	const float tolerance = 1e-5f;
+	glm::vec2 target(x, z);
+	for (uint32_t binned = mCellStarts[cell]; binned < mCellStarts[cell + 1]; ++binned)
+	{
+		size_t candidate = mBinnedTriangles[binned];
+		const glm::vec3& p = vertices[indices[candidate * 3]].mPosition;
+		const glm::vec3& q = vertices[indices[candidate * 3 + 1]].mPosition;
+		const glm::vec3& r = vertices[indices[candidate * 3 + 2]].mPosition;
+		glm::vec2 P(p.x, p.z), Q(q.x, q.z), R(r.x, r.z);
+
+		// Signed areas in the xz plane, divided by the signed triangle area so both windings give positive weights inside
+		float area = (Q.x - P.x) * (R.y - P.y) - (R.x - P.x) * (Q.y - P.y);
+		if (area == 0.f) continue;
+		float U = ((Q.x - target.x) * (R.y - target.y) - (R.x - target.x) * (Q.y - target.y)) / area;
+		float V = ((R.x - target.x) * (P.y - target.y) - (P.x - target.x) * (R.y - target.y)) / area;
+		float W = 1.f - U - V;
+		if (U >= -tolerance && V >= -tolerance && W >= -tolerance)
+		{
+			triangle = candidate;
+			barycentric = glm::vec3(U, V, W);
+			return true;
+		}
+	}
+	return false;
+}
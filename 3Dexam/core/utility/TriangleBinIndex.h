@@ -0,0 +1,33 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "utility/VariableTypes.h"
+
+class Vertex;
+
+/*
+ * Triangles binned by their xz bounding box into a regular grid of cells, stored as a compressed sparse row index like CellBinIndex
+ * A triangle goes into every cell its bounding box touches, so a point query only tests the triangles of one cell
+ * Triangles keep their index buffer order inside a cell, so a query finds the same triangle as a linear scan over the index buffer
+ */
+class TriangleBinIndex
+{
+public:
+	void Build(const std::vector<Vertex>& vertices, const std::vector<Index>& indices);
+
+	// Triangle under (x, z) and the barycentric weights of its three corners, either winding is accepted
+	bool FindTriangle(const std::vector<Vertex>& vertices, const std::vector<Index>& indices, float x, float z, size_t& triangle, glm::vec3& barycentric) const;
+
+private:
+	/*
+	 * Private Member Variables
+	 */
+	std::vector<uint32_t> mCellStarts;
+	std::vector<uint32_t> mBinnedTriangles;
+	glm::vec2 mOrigin{ 0.f };
+	float mInverseCellSize{ 1.f };
+	int mCellsX{ 0 };
+	int mCellsZ{ 0 };
+};
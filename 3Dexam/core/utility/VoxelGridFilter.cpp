@@ -0,0 +1,282 @@
+#include "VoxelGridFilter.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <glm/glm.hpp>
+
+#include "CompactPointCloud.h"
+#include "graphical/Mesh.h"
+#include "ThreadPool.h"
+
+namespace
+{
+	struct VoxelKey
+	{
+		int32_t x{ 0 };
+		int32_t y{ 0 };
+		int32_t z{ 0 };
+
+		bool operator==(const VoxelKey& other) const { return x == other.x && y == other.y && z == other.z; }
+		bool operator<(const VoxelKey& other) const
+		{
+			if (x != other.x) return x < other.x;
+			if (z != other.z) return z < other.z;
+			return y < other.y;
+		}
+	};
+
+	struct VoxelKeyHash
+	{
+		size_t operator()(const VoxelKey& key) const
+		{
+			uint64_t hash = static_cast<uint32_t>(key.x) * 0x9E3779B97F4A7C15ull;
+			hash ^= static_cast<uint32_t>(key.y) * 0xC2B2AE3D27D4EB4Full;
+			hash ^= static_cast<uint32_t>(key.z) * 0x165667B19E3779F9ull;
+			return static_cast<size_t>(hash ^ (hash >> 29));
+		}
+	};
+
+	// Positions are summed in double so large survey coordinates keep their precision, colors stay between 0 and 1 and float is enough
+	struct VoxelSum
+	{
+		glm::dvec3 position{ 0.0 };
+		glm::vec3 color{ 0.f };
+		uint32_t count{ 0 };
+	};
+
+	// Open addressing with linear probing, a node based map spends most of its time allocating when nearly every point opens a voxel
+	class VoxelMap
+	{
+	public:
+		struct Slot
+		{
+			VoxelSum sum;
+			VoxelKey key;
+			bool bIsUsed{ false };
+		};
+
+		explicit VoxelMap(size_t expectedVoxels = 0)
+		{
+			size_t capacity = 64;
+			while (capacity < expectedVoxels * 2) capacity *= 2;
+			mSlots.resize(capacity);
+		}
+
+		VoxelSum& operator[](const VoxelKey& key)
+		{
+			if ((mSize + 1) * 2 > mSlots.size()) Grow();
+			size_t mask = mSlots.size() - 1;
+			for (size_t index = VoxelKeyHash()(key) & mask;; index = (index + 1) & mask)
+			{
+				Slot& slot = mSlots[index];
+				if (!slot.bIsUsed)
+				{
+					slot.key = key;
+					slot.bIsUsed = true;
+					mSize++;
+					return slot.sum;
+				}
+				if (slot.key == key) return slot.sum;
+			}
+		}
+
+		template <typename Visitor>
+		void ForEach(Visitor visitor) const
+		{
+			for (const Slot& slot : mSlots)
+			{
+				if (slot.bIsUsed) visitor(slot.key, slot.sum);
+			}
+		}
+
+		size_t GetSize() const { return mSize; }
+
+	private:
+		void Grow()
+		{
+			std::vector<Slot> oldSlots(mSlots.size() * 2);
+			oldSlots.swap(mSlots);
+			mSize = 0;
+			for (const Slot& slot : oldSlots)
+			{
+				if (slot.bIsUsed) (*this)[slot.key] = slot.sum;
+			}
+		}
+
+		std::vector<Slot> mSlots;
+		size_t mSize{ 0 };
+	};
+
+	// Runs task(begin, end) over about equal slices of [0, pointCount), one slice per thread
+	template <typename Task>
+	auto RunOverSlices(size_t pointCount, unsigned int threadCount, Task task)
+	{
+		using ResultType = decltype(task(size_t(0), size_t(0)));
+		size_t sliceCount = std::max<size_t>(1, std::min<size_t>(threadCount, pointCount / 4096));
+		std::vector<ResultType> results;
+		results.reserve(sliceCount);
+		if (sliceCount == 1)
+		{
+			results.emplace_back(task(size_t(0), pointCount));
+			return results;
+		}
+
+		ThreadPool pool(static_cast<unsigned int>(sliceCount));
+		std::vector<std::future<ResultType>> sliceResults;
+		for (size_t slice = 0; slice < sliceCount; ++slice)
+		{
+			size_t begin = pointCount * slice / sliceCount;
+			size_t end = pointCount * (slice + 1) / sliceCount;
+			sliceResults.emplace_back(pool.Submit([=]() { return task(begin, end); }));
+		}
+		for (auto& result : sliceResults)
+		{
+			results.emplace_back(result.get());
+		}
+		return results;
+	}
+
+	template <typename GetPosition, typename GetColor>
+	std::vector<std::pair<VoxelKey, VoxelSum>> BuildVoxels(size_t pointCount, GetPosition getPosition, GetColor getColor, float voxelSize, unsigned int threadCount)
+	{
+		threadCount = ThreadPool::ResolveThreadCount(threadCount);
+
+		// The voxel indices are counted from the minimum corner, so they fit in int32 for any sensible voxel size
+		std::vector<std::pair<glm::vec3, glm::vec3>> sliceBounds = RunOverSlices(pointCount, threadCount, [&](size_t begin, size_t end)
+			{
+				glm::vec3 minimum(std::numeric_limits<float>::max());
+				glm::vec3 maximum(std::numeric_limits<float>::lowest());
+				for (size_t i = begin; i < end; ++i)
+				{
+					glm::vec3 position = getPosition(i);
+					minimum = glm::min(minimum, position);
+					maximum = glm::max(maximum, position);
+				}
+				return std::make_pair(minimum, maximum);
+			});
+		glm::dvec3 origin(std::numeric_limits<double>::max());
+		glm::dvec3 extent(std::numeric_limits<double>::lowest());
+		for (const auto& bounds : sliceBounds)
+		{
+			origin = glm::min(origin, glm::dvec3(bounds.first));
+			extent = glm::max(extent, glm::dvec3(bounds.second));
+		}
+
+		// A scan is close to a surface, so the occupied voxels are estimated from the xz footprint rather than the point count
+		// Maps start at that estimate, never above a quarter of their slice, and Grow() takes over where the scan folds or stacks
+		const double inverseVoxelSize = 1.0 / voxelSize;
+		glm::dvec3 voxelCounts = glm::floor((extent - origin) * inverseVoxelSize) + 1.0;
+		double footprintVoxels = std::min(voxelCounts.x * voxelCounts.z, static_cast<double>(pointCount));
+
+		// Every thread fills its own voxel map from its slice of the points
+		std::vector<VoxelMap> sliceVoxels = RunOverSlices(pointCount, threadCount, [&](size_t begin, size_t end)
+			{
+				VoxelMap voxels(std::min((end - begin) / 4, static_cast<size_t>(footprintVoxels)));
+				for (size_t i = begin; i < end; ++i)
+				{
+					glm::dvec3 position(getPosition(i));
+					glm::dvec3 cell = glm::floor((position - origin) * inverseVoxelSize);
+					VoxelKey key{ static_cast<int32_t>(cell.x), static_cast<int32_t>(cell.y), static_cast<int32_t>(cell.z) };
+
+					VoxelSum& sum = voxels[key];
+					sum.position += position;
+					sum.color += getColor(i);
+					sum.count++;
+				}
+				return voxels;
+			});
+
+		// Merging the maps in slice order
+		VoxelMap& voxels = sliceVoxels[0];
+		for (size_t slice = 1; slice < sliceVoxels.size(); ++slice)
+		{
+			sliceVoxels[slice].ForEach([&](const VoxelKey& key, const VoxelSum& sliceSum)
+				{
+					VoxelSum& sum = voxels[key];
+					sum.position += sliceSum.position;
+					sum.color += sliceSum.color;
+					sum.count += sliceSum.count;
+				});
+			sliceVoxels[slice] = VoxelMap();
+		}
+
+		std::vector<std::pair<VoxelKey, VoxelSum>> sortedVoxels;
+		sortedVoxels.reserve(voxels.GetSize());
+		voxels.ForEach([&](const VoxelKey& key, const VoxelSum& sum) { sortedVoxels.emplace_back(key, sum); });
+		std::sort(sortedVoxels.begin(), sortedVoxels.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+		return sortedVoxels;
+	}
+
+	void PrintDownsampleStats(size_t pointsBefore, size_t pointsAfter, float voxelSize, std::chrono::high_resolution_clock::time_point startTime)
+	{
+		std::chrono::duration<double> elapsedTime = std::chrono::high_resolution_clock::now() - startTime;
+		std::cout << "Voxel grid (size " << voxelSize << "): " << pointsBefore << " -> " << pointsAfter << " points in " << elapsedTime.count() << " s\n";
+	}
+}
+
+size_t VoxelGridFilter::Downsample(std::vector<Vertex>& vertices, float voxelSize, bool usingColors, unsigned int threadCount)
+{
+	if (voxelSize <= 0.f || vertices.empty()) return vertices.size();
+
+	auto startTime = std::chrono::high_resolution_clock::now();
+	auto voxels = BuildVoxels(vertices.size(),
+		[&](size_t i) { return vertices[i].mPosition; },
+		[&](size_t i) { return vertices[i].mColor; },
+		voxelSize, threadCount);
+
+	std::vector<Vertex> downsampled;
+	downsampled.reserve(voxels.size());
+	for (const auto& [key, sum] : voxels)
+	{
+		glm::vec3 position(sum.position / static_cast<double>(sum.count));
+		glm::vec3 color = sum.color / static_cast<float>(sum.count);
+		if (usingColors)
+		{
+			downsampled.emplace_back(position.x, position.y, position.z, color.r, color.g, color.b);
+		}
+		else
+		{
+			downsampled.emplace_back(position.x, position.y, position.z);
+		}
+	}
+
+	PrintDownsampleStats(vertices.size(), downsampled.size(), voxelSize, startTime);
+	vertices.swap(downsampled);
+	return vertices.size();
+}
+
+size_t VoxelGridFilter::Downsample(CompactPointCloud& points, float voxelSize, unsigned int threadCount)
+{
+	if (voxelSize <= 0.f || points.IsEmpty()) return points.GetPointCount();
+
+	auto startTime = std::chrono::high_resolution_clock::now();
+	auto voxels = BuildVoxels(points.GetPointCount(),
+		[&](size_t i) { return points.GetPosition(i); },
+		[&](size_t i) { return points.GetColor(i); },
+		voxelSize, threadCount);
+
+	// The averaged points are requantised against their own, slightly tighter, bounds
+	glm::vec3 boundsMin(std::numeric_limits<float>::max());
+	glm::vec3 boundsMax(std::numeric_limits<float>::lowest());
+	for (const auto& [key, sum] : voxels)
+	{
+		glm::vec3 position(sum.position / static_cast<double>(sum.count));
+		boundsMin = glm::min(boundsMin, position);
+		boundsMax = glm::max(boundsMax, position);
+	}
+
+	CompactPointCloud downsampled;
+	downsampled.SetBounds(boundsMin, boundsMax);
+	downsampled.Reserve(voxels.size());
+	for (const auto& [key, sum] : voxels)
+	{
+		downsampled.AddPoint(glm::vec3(sum.position / static_cast<double>(sum.count)), sum.color / static_cast<float>(sum.count));
+	}
+
+	PrintDownsampleStats(points.GetPointCount(), downsampled.GetPointCount(), voxelSize, startTime);
+	points = std::move(downsampled);
+	return points.GetPointCount();
+}
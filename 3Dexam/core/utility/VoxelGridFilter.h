@@ -0,0 +1,17 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+class CompactPointCloud;
+class Vertex;
+
+/*
+ * Voxel grid subsampling, every occupied voxel is replaced by one point at the average position and color of its points
+ * Points are accumulated into hashed voxel maps in parallel, the result is sorted by voxel so it does not depend on the thread count
+ */
+class VoxelGridFilter
+{
+public:
+	static size_t Downsample(std::vector<Vertex>& vertices, float voxelSize, bool usingColors, unsigned int threadCount = 0);
+	static size_t Downsample(CompactPointCloud& points, float voxelSize, unsigned int threadCount = 0);
+};
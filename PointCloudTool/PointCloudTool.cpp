@@ -0,0 +1,40 @@
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "utility/PointCloudCache.h"
+#include "utility/PointCloudConverter.h"
+
+/*
+ * Offline point-cloud conversion, so the terrain never has to parse the raw export at startup
+ * Usage: PointCloudTool <input> <output> [--binary] [--no-colors] [--threads N]
+ * Writing to a .pcbin file always uses the binary format, which the terrain loader can open directly
+ */
+int main(int argc, char* argv[])
+{
+	if (argc < 3)
+	{
+		std::cerr << "Usage: PointCloudTool <input> <output> [--binary] [--no-colors] [--threads N]" << std::endl;
+		return 1;
+	}
+
+	PointCloudConvertSettings settings;
+	settings.inputPath = argv[1];
+	settings.outputPath = argv[2];
+	settings.writeBinary = PointCloudCache::IsBinaryPointFile(settings.outputPath);
+
+	for (int i = 3; i < argc; ++i)
+	{
+		std::string argument = argv[i];
+		if (argument == "--binary") settings.writeBinary = true;
+		else if (argument == "--no-colors") settings.usingColors = false;
+		else if (argument == "--threads" && i + 1 < argc) settings.transformThreads = static_cast<unsigned int>(std::atoi(argv[++i]));
+		else
+		{
+			std::cerr << "Unknown argument: " << argument << std::endl;
+			return 1;
+		}
+	}
+
+	return PointCloudConverter::Convert(settings) ? 0 : 1;
+}
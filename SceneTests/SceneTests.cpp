@@ -0,0 +1,147 @@
+#define STB_IMAGE_IMPLEMENTATION
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include <stb/stb_image.h>
+
+#include "application/Scene.h"
+#include "utility/PointCloudCache.h"
+
+// Gently sloped square of points, enough for a small terrain grid the test actors can roll on
+static bool WriteSlopePointFile(const std::string& filePath)
+{
+	PointCloudCacheWriter writer;
+	if (!writer.Open(filePath, true, 0, 0)) return false;
+
+	const int pointsPerSide = 101;
+	for (int i = 0; i < pointsPerSide; ++i)
+	{
+		for (int j = 0; j < pointsPerSide; ++j)
+		{
+			float x = -50.f + i;
+			float z = -50.f + j;
+			float position[3] = { x, 0.05f * x + 0.02f * z, z };
+			float color[3] = { 0.5f, 0.5f, 0.5f };
+			writer.AddPoints(position, color, 1);
+		}
+	}
+	return writer.Finish();
+}
+
+// Scene with the terrain and a few dynamic actors, set up the way LoadActors() and SpawnSetup() do it but without any GL objects
+static void SetupPhysicsScene(Scene& scene, const std::shared_ptr<Mesh>& terrain)
+{
+	scene.mSceneMeshes["PunktSkyMesh"] = terrain;
+	scene.mSceneActors["PunktSky"] = std::make_shared<Actor>("PunktSkyMesh", terrain, glm::vec3{ 0.f, 0.f, 0.f }, glm::vec3{ 1.f, 0.f, 0.f }, 0.f, 1.f, Actor::ActorType::STATIC, nullptr, false, "");
+	scene.minTerrainLimit = terrain->minTerrainLimit;
+	scene.maxTerrainLimit = terrain->maxTerrainLimit;
+	scene.CustomArea = terrain->customArea;
+
+	// The player actor lives in the scene actors, the spawned balls in their own map, both are simulated by PhysicsStep()
+	scene.mSceneActors["Player"] = std::make_shared<Actor>("SphereMesh", nullptr, glm::vec3{ 20.f, 5.f, -20.f }, glm::vec3{ 0.f, 1.f, 0.f }, 0.f, 1.f, Actor::ActorType::DYNAMICOBJECT, nullptr, false, "");
+	for (int ball = 0; ball < 4; ++ball)
+	{
+		glm::vec3 position{ -10.f + ball * 10.f, 5.f, 20.f };
+		scene.mSceneBallActors["Ball" + std::to_string(ball)] = std::make_shared<Actor>("SphereMesh", nullptr, position, glm::vec3{ 0.f, 1.f, 0.f }, 0.f, 1.f, Actor::ActorType::DYNAMICOBJECT, nullptr, false, "");
+	}
+	scene.shouldSimualtePhysics = true;
+}
+
+// Every dynamic actor has to be integrated exactly once per physics step
+static bool CheckIntegrations(Scene& scene, uint64_t expectedSteps, const std::string& testName)
+{
+	bool bIsPassing = scene.physicsStepCount == expectedSteps;
+	if (!bIsPassing)
+	{
+		std::cerr << testName << ": " << scene.physicsStepCount << " physics steps, expected " << expectedSteps << std::endl;
+	}
+	for (auto* actorMap : { &scene.mSceneActors, &scene.mSceneBallActors })
+	{
+		for (auto& actors : *actorMap)
+		{
+			if (actors.second->mActorType != Actor::DYNAMICOBJECT) continue;
+			if (actors.second->mPhysicsIntegrations != expectedSteps)
+			{
+				std::cerr << testName << ": " << actors.first << " integrated " << actors.second->mPhysicsIntegrations << " times in " << expectedSteps << " steps" << std::endl;
+				bIsPassing = false;
+			}
+		}
+	}
+	std::cout << (bIsPassing ? "PASSED " : "FAILED ") << testName << "\n";
+	return bIsPassing;
+}
+
+/*
+ * Headless checks of the scene simulation pass, no window or GL context is created
+ * Usage: SceneTests [steps]
+ * Returns 0 when every check passes
+ */
+int main(int argc, char* argv[])
+{
+	const uint64_t steps = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 600;
+	const std::string terrainFile = "SceneTests_terrain.pcbin";
+	if (!WriteSlopePointFile(terrainFile))
+	{
+		std::cerr << "Could not write: " << terrainFile << std::endl;
+		return 1;
+	}
+
+	PointCloudSettings terrainSettings;
+	terrainSettings.filePath = terrainFile;
+	auto terrain = std::make_shared<Mesh>(terrainSettings, 101, false, glm::vec3(1.f));
+	std::remove(terrainFile.c_str());
+	if (terrain->mVertices.empty())
+	{
+		std::cerr << "No terrain was built from: " << terrainFile << std::endl;
+		return 1;
+	}
+
+	bool bIsPassing = true;
+
+	// Stepping the physics directly
+	{
+		Scene scene;
+		SetupPhysicsScene(scene, terrain);
+		for (uint64_t step = 0; step < steps; ++step)
+		{
+			scene.PhysicsStep(scene.physicsTimeStep);
+		}
+		bIsPassing &= CheckIntegrations(scene, steps, "PhysicsStep runs each dynamic actor once");
+	}
+
+	// Going through the simulation pass the game loop calls, one fixed step worth of frame time per frame
+	{
+		Scene scene;
+		SetupPhysicsScene(scene, terrain);
+		for (uint64_t frame = 0; frame < steps; ++frame)
+		{
+			scene.Update(scene.physicsTimeStep);
+		}
+		bIsPassing &= CheckIntegrations(scene, steps, "Update runs one physics step per fixed step of frame time");
+	}
+
+	// A whole frame the way the game loop runs it, the simulation pass and then the per actor logic RenderScene() runs on every map
+	// Drawing an actor must never move it, so the integrations still have to match the physics steps
+	{
+		Scene scene;
+		SetupPhysicsScene(scene, terrain);
+		scene.mBSplineActors["Spline0"] = std::make_shared<Actor>("BSplineMesh0", nullptr, glm::vec3{ 0.f, 0.f, 0.f }, glm::vec3{ 1.f, 0.f, 0.f }, 0.f, 1.f, Actor::ActorType::SPLINE, nullptr, false, "");
+		scene.mBSplineActors["Spline0"]->ballPtr = scene.mSceneBallActors["Ball0"];
+		for (uint64_t frame = 0; frame < steps; ++frame)
+		{
+			scene.Update(scene.physicsTimeStep);
+			for (auto* actorMap : { &scene.mSceneActors, &scene.mSceneBallActors, &scene.mBSplineActors })
+			{
+				for (auto& actors : *actorMap)
+				{
+					scene.ActorSceneLogic(actors);
+				}
+			}
+		}
+		bIsPassing &= CheckIntegrations(scene, steps, "Rendering a frame does not integrate physics");
+	}
+
+	return bIsPassing ? 0 : 1;
+}
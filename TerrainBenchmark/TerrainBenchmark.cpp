@@ -0,0 +1,513 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+#include <glm/gtc/constants.hpp>
+
+#include "graphical/Mesh.h"
+#include "utility/CompactPointCloud.h"
+#include "utility/PointCloudCache.h"
+#include "utility/ReadWriteFiles.h"
+#include "utility/ThreadPool.h"
+#include "utility/TriangleBVH.h"
+
+// Synthetic survey of rolling hills over a square area, same seed for the same point count so every run grids identical points
+static bool WriteSyntheticPointFile(const std::string& filePath, size_t pointCount, float areaSize)
+{
+	PointCloudCacheWriter writer;
+	if (!writer.Open(filePath, true, 0, 0)) return false;
+
+	std::mt19937 generator(static_cast<unsigned int>(pointCount));
+	std::uniform_real_distribution<float> coordinate(-areaSize / 2.f, areaSize / 2.f);
+	std::uniform_real_distribution<float> noise(-0.25f, 0.25f);
+
+	const size_t batchSize = 65536;
+	std::vector<float> positions;
+	std::vector<float> colors;
+	for (size_t written = 0; written < pointCount; written += batchSize)
+	{
+		size_t batch = std::min(batchSize, pointCount - written);
+		positions.resize(batch * 3);
+		colors.resize(batch * 3);
+		for (size_t i = 0; i < batch; ++i)
+		{
+			float x = coordinate(generator);
+			float z = coordinate(generator);
+			float y = 20.f * std::sin(x * 0.01f) * std::cos(z * 0.013f) + noise(generator);
+			positions[i * 3] = x;
+			positions[i * 3 + 1] = y;
+			positions[i * 3 + 2] = z;
+			colors[i * 3] = 0.3f;
+			colors[i * 3 + 1] = 0.5f + y * 0.01f;
+			colors[i * 3 + 2] = 0.2f;
+		}
+		writer.AddPoints(positions.data(), colors.data(), batch);
+	}
+	return writer.Finish();
+}
+
+// The grid population as it was before CellBinIndex, one vector of point indices per cell and the samples gathered into vectors
+// Cells are counted from the minimum corner like CellBinIndex does, so both layouts average exactly the same points
+static std::vector<float> PopulateGridNestedVectors(int resolution, const std::vector<Vertex>& points, float gridWidth, float gridHeight)
+{
+	float xSpacing = gridWidth / static_cast<float>(resolution - 1);
+	float zSpacing = gridHeight / static_cast<float>(resolution - 1);
+	float cellSize = std::min(xSpacing, zSpacing);
+	float halfBox = cellSize / 2.f;
+	int cellsX = static_cast<int>(std::ceil(gridWidth / cellSize));
+	int cellsZ = static_cast<int>(std::ceil(gridHeight / cellSize));
+	auto CellOf = [&](float coordinate, float halfSize, int cells) { return std::clamp(static_cast<int>(std::floor((coordinate + halfSize) / cellSize)), 0, cells - 1); };
+
+	std::vector<std::vector<std::vector<size_t>>> gridVector(cellsX, std::vector<std::vector<size_t>>(cellsZ));
+	for (size_t index = 0; index < points.size(); ++index)
+	{
+		const glm::vec3& position = points[index].mPosition;
+		gridVector[CellOf(position.x, gridWidth / 2.f, cellsX)][CellOf(position.z, gridHeight / 2.f, cellsZ)].emplace_back(index);
+	}
+
+	std::vector<float> heights(static_cast<size_t>(resolution) * resolution, 0.f);
+	for (int i = 0; i < resolution; ++i)
+	{
+		float posX = -gridWidth / 2.f + i * xSpacing;
+		for (int j = 0; j < resolution; ++j)
+		{
+			float posZ = -gridHeight / 2.f + j * zSpacing;
+			float boxMinX = posX - halfBox;
+			float boxMaxX = posX + halfBox;
+			float boxMinZ = posZ - halfBox;
+			float boxMaxZ = posZ + halfBox;
+
+			std::vector<float> yValues, rValues, gValues, bValues;
+			for (int cellX = CellOf(boxMinX, gridWidth / 2.f, cellsX); cellX <= CellOf(boxMaxX, gridWidth / 2.f, cellsX); ++cellX)
+			{
+				for (int cellZ = CellOf(boxMinZ, gridHeight / 2.f, cellsZ); cellZ <= CellOf(boxMaxZ, gridHeight / 2.f, cellsZ); ++cellZ)
+				{
+					for (size_t index : gridVector[cellX][cellZ])
+					{
+						const Vertex& point = points[index];
+						if (point.mPosition.x >= boxMinX && point.mPosition.x <= boxMaxX &&
+							point.mPosition.z >= boxMinZ && point.mPosition.z <= boxMaxZ)
+						{
+							yValues.push_back(point.mPosition.y);
+							rValues.push_back(point.mColor.r);
+							gValues.push_back(point.mColor.g);
+							bValues.push_back(point.mColor.b);
+						}
+					}
+				}
+			}
+
+			if (!yValues.empty())
+			{
+				double sum = 0.0;
+				for (float y : yValues) sum += y;
+				heights[static_cast<size_t>(i) * resolution + j] = static_cast<float>(sum / yValues.size());
+			}
+		}
+	}
+	return heights;
+}
+
+// Loads the same points as full vertices and populates the grid with the nested vectors and with Mesh::GenerateAndPopulateGrid
+static bool CompareWithNestedVectors(Mesh& terrain, const PointCloudSettings& settings, int resolution)
+{
+	std::vector<Vertex> vertices;
+	if (!ReadWriteFiles::FromBinaryDataToVertexVector(settings.filePath, vertices, settings.usingColors) || vertices.empty()) return false;
+
+	// Recentering the vertices the way the terrain loader does before gridding
+	float minX = std::numeric_limits<float>::max();
+	float maxX = std::numeric_limits<float>::lowest();
+	float minZ = std::numeric_limits<float>::max();
+	float maxZ = std::numeric_limits<float>::lowest();
+	for (const auto& vertex : vertices)
+	{
+		minX = std::min(minX, vertex.mPosition.x);
+		maxX = std::max(maxX, vertex.mPosition.x);
+		minZ = std::min(minZ, vertex.mPosition.z);
+		maxZ = std::max(maxZ, vertex.mPosition.z);
+	}
+	for (auto& vertex : vertices)
+	{
+		vertex.mPosition.x -= (minX + maxX) / 2.f;
+		vertex.mPosition.z -= (minZ + maxZ) / 2.f;
+	}
+
+	auto nestedStart = std::chrono::high_resolution_clock::now();
+	std::vector<float> nestedHeights = PopulateGridNestedVectors(resolution, vertices, maxX - minX, maxZ - minZ);
+	std::chrono::duration<double> nestedTime = std::chrono::high_resolution_clock::now() - nestedStart;
+
+	terrain.mVertices.clear();
+	terrain.customArea.clear();
+	auto binnedStart = std::chrono::high_resolution_clock::now();
+	terrain.GenerateAndPopulateGrid(resolution, vertices, minX, maxX, minZ, maxZ, glm::vec3(1.f));
+	std::chrono::duration<double> binnedTime = std::chrono::high_resolution_clock::now() - binnedStart;
+
+	float maxHeightDifference = 0.f;
+	for (size_t sample = 0; sample < nestedHeights.size(); ++sample)
+	{
+		maxHeightDifference = std::max(maxHeightDifference, std::abs(nestedHeights[sample] - terrain.mVertices[sample].mPosition.y));
+	}
+
+	std::cout << "Nested cell vectors (1 thread): " << nestedTime.count() << " s\n";
+	std::cout << "CellBinIndex (" << ThreadPool::ResolveThreadCount(settings.threadCount) << " threads): " << binnedTime.count() << " s\n";
+	std::cout << "Speedup: " << nestedTime.count() / binnedTime.count() << "x, largest height difference " << maxHeightDifference << "\n";
+	return true;
+}
+
+// Closed bumpy sphere, a mesh with overhangs and several surfaces over the same x and z, so it is not something the terrain grid can hold
+static void GenerateRockMesh(size_t triangleCount, float radius, std::vector<Vertex>& vertices, std::vector<Index>& indices)
+{
+	int sectorCount = std::max(8, static_cast<int>(std::sqrt(static_cast<double>(triangleCount))));
+	int stackCount = std::max(4, sectorCount / 2);
+
+	vertices.clear();
+	indices.clear();
+	for (int i = 0; i <= stackCount; ++i)
+	{
+		float stackAngle = glm::pi<float>() * i / stackCount;
+		for (int j = 0; j <= sectorCount; ++j)
+		{
+			float sectorAngle = 2.f * glm::pi<float>() * j / sectorCount;
+			float bump = 1.f + 0.15f * std::sin(5.f * sectorAngle) * std::sin(7.f * stackAngle) + 0.03f * std::sin(23.f * sectorAngle + 3.f * stackAngle) * std::cos(19.f * stackAngle);
+			// Poles are put exactly on the axis, sin(pi) is not quite zero and the sliver triangles it leaves break the xz barycentrics
+			float ringRadius = (i == 0 || i == stackCount) ? 0.f : radius * bump * std::sin(stackAngle);
+			vertices.emplace_back(ringRadius * std::cos(sectorAngle), radius * bump * std::cos(stackAngle), ringRadius * std::sin(sectorAngle));
+		}
+	}
+	for (int i = 0; i < stackCount; ++i)
+	{
+		for (int j = 0; j < sectorCount; ++j)
+		{
+			Index k1 = static_cast<Index>(i * (sectorCount + 1) + j);
+			Index k2 = k1 + static_cast<Index>(sectorCount + 1);
+			// The first and last stacks are fans around the poles, one triangle per sector
+			if (i != 0) indices.insert(indices.end(), { k1, k2, k1 + 1 });
+			if (i != stackCount - 1) indices.insert(indices.end(), { k1 + 1, k2, k2 + 1 });
+		}
+	}
+}
+
+// Same closest point as TriangleBVH uses (Ericson, Real-Time Collision Detection 5.1.5), the linear scan has to agree with it exactly
+static glm::vec3 ClosestPointOnTriangle(const glm::vec3& p, const glm::vec3& a, const glm::vec3& b, const glm::vec3& c)
+{
+	glm::vec3 ab = b - a, ac = c - a, ap = p - a;
+	float d1 = glm::dot(ab, ap), d2 = glm::dot(ac, ap);
+	if (d1 <= 0.f && d2 <= 0.f) return a;
+
+	glm::vec3 bp = p - b;
+	float d3 = glm::dot(ab, bp), d4 = glm::dot(ac, bp);
+	if (d3 >= 0.f && d4 <= d3) return b;
+
+	float vc = d1 * d4 - d3 * d2;
+	if (vc <= 0.f && d1 >= 0.f && d3 <= 0.f) return a + ab * (d1 / (d1 - d3));
+
+	glm::vec3 cp = p - c;
+	float d5 = glm::dot(ab, cp), d6 = glm::dot(ac, cp);
+	if (d6 >= 0.f && d5 <= d6) return c;
+
+	float vb = d5 * d2 - d1 * d6;
+	if (vb <= 0.f && d2 >= 0.f && d6 <= 0.f) return a + ac * (d2 / (d2 - d6));
+
+	float va = d3 * d6 - d5 * d4;
+	if (va <= 0.f && (d4 - d3) >= 0.f && (d5 - d6) >= 0.f) return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+
+	float denominator = 1.f / (va + vb + vc);
+	return a + ab * (vb * denominator) + ac * (vc * denominator);
+}
+
+/*
+ * Linear scans over every triangle, the reference the BVH queries are checked and timed against
+ */
+static bool LinearProjectDown(const std::vector<Vertex>& vertices, const std::vector<Index>& indices, float x, float z, float fromHeight, float& height)
+{
+	const float tolerance = 1e-5f;
+	bool found = false;
+	height = std::numeric_limits<float>::lowest();
+	for (size_t triangle = 0; triangle < indices.size() / 3; ++triangle)
+	{
+		const glm::vec3& p = vertices[indices[triangle * 3]].mPosition;
+		const glm::vec3& q = vertices[indices[triangle * 3 + 1]].mPosition;
+		const glm::vec3& r = vertices[indices[triangle * 3 + 2]].mPosition;
+
+		float area = (q.x - p.x) * (r.z - p.z) - (r.x - p.x) * (q.z - p.z);
+		if (area == 0.f) continue;
+		float U = ((q.x - x) * (r.z - z) - (r.x - x) * (q.z - z)) / area;
+		float V = ((r.x - x) * (p.z - z) - (p.x - x) * (r.z - z)) / area;
+		float W = 1.f - U - V;
+		if (U < -tolerance || V < -tolerance || W < -tolerance) continue;
+
+		float triangleHeight = U * p.y + V * q.y + W * r.y;
+		if (triangleHeight > fromHeight || triangleHeight <= height) continue;
+		found = true;
+		height = triangleHeight;
+	}
+	return found;
+}
+
+static bool LinearRaycast(const std::vector<Vertex>& vertices, const std::vector<Index>& indices, const glm::vec3& origin, const glm::vec3& direction, float maxDistance, float& distance)
+{
+	bool found = false;
+	distance = maxDistance;
+	for (size_t triangle = 0; triangle < indices.size() / 3; ++triangle)
+	{
+		const glm::vec3& p = vertices[indices[triangle * 3]].mPosition;
+		glm::vec3 edge1 = vertices[indices[triangle * 3 + 1]].mPosition - p;
+		glm::vec3 edge2 = vertices[indices[triangle * 3 + 2]].mPosition - p;
+		glm::vec3 pvec = glm::cross(direction, edge2);
+		float determinant = glm::dot(edge1, pvec);
+		if (std::abs(determinant) < 1e-12f) continue;
+		float inverseDeterminant = 1.f / determinant;
+		glm::vec3 tvec = origin - p;
+		float v = glm::dot(tvec, pvec) * inverseDeterminant;
+		if (v < 0.f || v > 1.f) continue;
+		glm::vec3 qvec = glm::cross(tvec, edge1);
+		float w = glm::dot(direction, qvec) * inverseDeterminant;
+		if (w < 0.f || v + w > 1.f) continue;
+		float triangleDistance = glm::dot(edge2, qvec) * inverseDeterminant;
+		if (triangleDistance < 0.f || triangleDistance > distance) continue;
+		found = true;
+		distance = triangleDistance;
+	}
+	return found;
+}
+
+static void LinearOverlapSphere(const std::vector<Vertex>& vertices, const std::vector<Index>& indices, const glm::vec3& center, float radius, std::vector<size_t>& triangles)
+{
+	triangles.clear();
+	for (size_t triangle = 0; triangle < indices.size() / 3; ++triangle)
+	{
+		glm::vec3 closest = ClosestPointOnTriangle(center, vertices[indices[triangle * 3]].mPosition, vertices[indices[triangle * 3 + 1]].mPosition, vertices[indices[triangle * 3 + 2]].mPosition);
+		glm::vec3 offset = closest - center;
+		if (glm::dot(offset, offset) <= radius * radius) triangles.push_back(triangle);
+	}
+}
+
+static void PrintQueryTimes(const std::string& query, size_t queryCount, double bvhTime, double linearTime, size_t hits, size_t mismatches)
+{
+	std::cout << query << ": BVH " << bvhTime * 1e6 / queryCount << " us, linear scan " << linearTime * 1e6 / queryCount << " us per query, speedup " << linearTime / bvhTime
+		<< "x, " << hits << " of " << queryCount << " hit, " << mismatches << " mismatches\n";
+}
+
+// Builds a TriangleBVH over a generated rock and runs each query type through the BVH and through a linear scan of the same triangles
+// Returns false when any query disagrees with the linear scan
+static bool RunBVHBenchmark(size_t triangleCount, size_t queryCount)
+{
+	const float radius = 100.f;
+	std::vector<Vertex> vertices;
+	std::vector<Index> indices;
+	GenerateRockMesh(triangleCount, radius, vertices, indices);
+
+	TriangleBVH bvh;
+	auto buildStart = std::chrono::high_resolution_clock::now();
+	bvh.Build(vertices, indices);
+	std::chrono::duration<double> buildTime = std::chrono::high_resolution_clock::now() - buildStart;
+	std::cout << indices.size() / 3 << " triangles, BVH of " << bvh.GetNodeCount() << " nodes and depth " << bvh.GetDepth() << " built in " << buildTime.count() << " s\n";
+
+	// Same queries for both sides, drawn up front so only the queries themselves are timed
+	std::mt19937 generator(static_cast<unsigned int>(triangleCount));
+	std::uniform_real_distribution<float> around(-1.5f * radius, 1.5f * radius);
+	std::uniform_real_distribution<float> inside(-radius, radius);
+	std::vector<glm::vec3> origins(queryCount), targets(queryCount);
+	for (size_t query = 0; query < queryCount; ++query)
+	{
+		origins[query] = glm::vec3(around(generator), around(generator), around(generator));
+		targets[query] = glm::vec3(inside(generator), inside(generator), inside(generator));
+	}
+	bool bIsMatching = true;
+
+	// ProjectDown from a random height, the start is often inside the rock so the lower surface is the answer
+	{
+		std::vector<uint8_t> bvhFound(queryCount), linearFound(queryCount);
+		std::vector<float> bvhHeights(queryCount), linearHeights(queryCount);
+		auto bvhStart = std::chrono::high_resolution_clock::now();
+		for (size_t query = 0; query < queryCount; ++query)
+		{
+			TriangleHit hit;
+			bvhFound[query] = bvh.ProjectDown(targets[query].x, targets[query].z, origins[query].y, hit);
+			bvhHeights[query] = hit.point.y;
+		}
+		std::chrono::duration<double> bvhTime = std::chrono::high_resolution_clock::now() - bvhStart;
+		auto linearStart = std::chrono::high_resolution_clock::now();
+		for (size_t query = 0; query < queryCount; ++query)
+		{
+			linearFound[query] = LinearProjectDown(vertices, indices, targets[query].x, targets[query].z, origins[query].y, linearHeights[query]);
+		}
+		std::chrono::duration<double> linearTime = std::chrono::high_resolution_clock::now() - linearStart;
+
+		size_t hits = 0;
+		size_t mismatches = 0;
+		for (size_t query = 0; query < queryCount; ++query)
+		{
+			hits += bvhFound[query];
+			if (bvhFound[query] != linearFound[query] || (bvhFound[query] && std::abs(bvhHeights[query] - linearHeights[query]) > 1e-3f)) mismatches++;
+		}
+		PrintQueryTimes("ProjectDown", queryCount, bvhTime.count(), linearTime.count(), hits, mismatches);
+		bIsMatching &= mismatches == 0;
+	}
+
+	// Raycast from outside and inside the rock towards a point within it
+	{
+		std::vector<uint8_t> bvhFound(queryCount), linearFound(queryCount);
+		std::vector<float> bvhDistances(queryCount), linearDistances(queryCount);
+		auto bvhStart = std::chrono::high_resolution_clock::now();
+		for (size_t query = 0; query < queryCount; ++query)
+		{
+			TriangleHit hit;
+			bvhFound[query] = bvh.Raycast(origins[query], targets[query] - origins[query], 10.f, hit);
+			bvhDistances[query] = hit.distance;
+		}
+		std::chrono::duration<double> bvhTime = std::chrono::high_resolution_clock::now() - bvhStart;
+		auto linearStart = std::chrono::high_resolution_clock::now();
+		for (size_t query = 0; query < queryCount; ++query)
+		{
+			linearFound[query] = LinearRaycast(vertices, indices, origins[query], targets[query] - origins[query], 10.f, linearDistances[query]);
+		}
+		std::chrono::duration<double> linearTime = std::chrono::high_resolution_clock::now() - linearStart;
+
+		size_t hits = 0;
+		size_t mismatches = 0;
+		for (size_t query = 0; query < queryCount; ++query)
+		{
+			hits += bvhFound[query];
+			if (bvhFound[query] != linearFound[query] || (bvhFound[query] && std::abs(bvhDistances[query] - linearDistances[query]) > 1e-5f)) mismatches++;
+		}
+		PrintQueryTimes("Raycast", queryCount, bvhTime.count(), linearTime.count(), hits, mismatches);
+		bIsMatching &= mismatches == 0;
+	}
+
+	// OverlapSphere around points near the surface, the touched triangles have to be the same set
+	{
+		const float sphereRadius = 0.05f * radius;
+		std::vector<std::vector<size_t>> bvhTriangles(queryCount), linearTriangles(queryCount);
+		std::vector<TriangleContact> contacts;
+		auto bvhStart = std::chrono::high_resolution_clock::now();
+		for (size_t query = 0; query < queryCount; ++query)
+		{
+			bvh.OverlapSphere(glm::normalize(targets[query]) * radius, sphereRadius, contacts);
+			for (const auto& contact : contacts) bvhTriangles[query].push_back(contact.triangle);
+		}
+		std::chrono::duration<double> bvhTime = std::chrono::high_resolution_clock::now() - bvhStart;
+		auto linearStart = std::chrono::high_resolution_clock::now();
+		for (size_t query = 0; query < queryCount; ++query)
+		{
+			LinearOverlapSphere(vertices, indices, glm::normalize(targets[query]) * radius, sphereRadius, linearTriangles[query]);
+		}
+		std::chrono::duration<double> linearTime = std::chrono::high_resolution_clock::now() - linearStart;
+
+		size_t hits = 0;
+		size_t mismatches = 0;
+		for (size_t query = 0; query < queryCount; ++query)
+		{
+			hits += !bvhTriangles[query].empty();
+			std::sort(bvhTriangles[query].begin(), bvhTriangles[query].end());
+			if (bvhTriangles[query] != linearTriangles[query]) mismatches++;
+		}
+		PrintQueryTimes("OverlapSphere", queryCount, bvhTime.count(), linearTime.count(), hits, mismatches);
+		bIsMatching &= mismatches == 0;
+	}
+	return bIsMatching;
+}
+
+/*
+ * Times the compactPoints terrain path (16 byte points, binned by PopulateGridFromPoints) on a synthetic point cloud
+ * Usage: TerrainBenchmark <pointCount> [--resolution N] [--threads N] [--file path] [--compare]
+ * --compare also loads the points as vertices and times the grid population with the old nested cell vectors against CellBinIndex
+ * The points are written to a .pcbin file first (TerrainBenchmark_<pointCount>.pcbin unless --file is given) and reused by later runs
+ *
+ * Usage: TerrainBenchmark --bvh <triangleCount> [--queries N]
+ * Builds a TriangleBVH over a generated rock and times Raycast, ProjectDown and OverlapSphere against a linear scan, returns 1 on any mismatch
+ */
+int main(int argc, char* argv[])
+{
+	if (argc < 2)
+	{
+		std::cerr << "Usage: TerrainBenchmark <pointCount> [--resolution N] [--threads N] [--file path] [--compare]" << std::endl;
+		std::cerr << "       TerrainBenchmark --bvh <triangleCount> [--queries N]" << std::endl;
+		return 1;
+	}
+
+	if (std::string(argv[1]) == "--bvh")
+	{
+		size_t triangleCount = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 0;
+		size_t queryCount = 1000;
+		for (int i = 3; i < argc; ++i)
+		{
+			std::string argument = argv[i];
+			if (argument == "--queries" && i + 1 < argc) queryCount = std::strtoull(argv[++i], nullptr, 10);
+			else
+			{
+				std::cerr << "Unknown argument: " << argument << std::endl;
+				return 1;
+			}
+		}
+		if (triangleCount == 0 || queryCount == 0)
+		{
+			std::cerr << "Needs at least one triangle and one query" << std::endl;
+			return 1;
+		}
+		return RunBVHBenchmark(triangleCount, queryCount) ? 0 : 1;
+	}
+
+	size_t pointCount = std::strtoull(argv[1], nullptr, 10);
+	int resolution = 1000;
+	bool bIsComparing = false;
+	PointCloudSettings settings;
+	settings.compactPoints = true;
+	settings.useBinaryCache = false;
+	settings.filePath = "TerrainBenchmark_" + std::to_string(pointCount) + ".pcbin";
+
+	for (int i = 2; i < argc; ++i)
+	{
+		std::string argument = argv[i];
+		if (argument == "--resolution" && i + 1 < argc) resolution = std::atoi(argv[++i]);
+		else if (argument == "--threads" && i + 1 < argc) settings.threadCount = static_cast<unsigned int>(std::atoi(argv[++i]));
+		else if (argument == "--file" && i + 1 < argc) settings.filePath = argv[++i];
+		else if (argument == "--compare") bIsComparing = true;
+		else
+		{
+			std::cerr << "Unknown argument: " << argument << std::endl;
+			return 1;
+		}
+	}
+	if (pointCount == 0 || resolution < 2 || !PointCloudCache::IsBinaryPointFile(settings.filePath))
+	{
+		std::cerr << "Needs at least one point, a resolution of 2 or more and a .pcbin file" << std::endl;
+		return 1;
+	}
+
+	if (!std::filesystem::exists(settings.filePath))
+	{
+		auto writeStart = std::chrono::high_resolution_clock::now();
+		if (!WriteSyntheticPointFile(settings.filePath, pointCount, 1000.f))
+		{
+			std::cerr << "Could not write: " << settings.filePath << std::endl;
+			return 1;
+		}
+		std::chrono::duration<double> writeTime = std::chrono::high_resolution_clock::now() - writeStart;
+		std::cout << "Synthetic point file written in " << writeTime.count() << " s\n";
+	}
+
+	std::cout << pointCount << " points, " << pointCount * sizeof(CompactPoint) / (1024.0 * 1024.0) << " MB as compact points, resolution " << resolution << "\n";
+	auto buildStart = std::chrono::high_resolution_clock::now();
+	Mesh terrain(settings, resolution, false, glm::vec3(1.f));
+	std::chrono::duration<double> buildTime = std::chrono::high_resolution_clock::now() - buildStart;
+	if (terrain.mVertices.empty())
+	{
+		std::cerr << "No terrain was built from: " << settings.filePath << std::endl;
+		return 1;
+	}
+	std::cout << "Terrain of " << terrain.mVertices.size() << " vertices built in " << buildTime.count() << " s\n";
+
+	if (bIsComparing && !CompareWithNestedVectors(terrain, settings, resolution))
+	{
+		std::cerr << "Could not load the points as vertices from: " << settings.filePath << std::endl;
+		return 1;
+	}
+	return 0;
+}